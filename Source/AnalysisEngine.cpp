@@ -0,0 +1,913 @@
+#include "AnalysisEngine.h"
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
+
+//==============================================================================
+AnalysisEngine::AnalysisEngine (int order)
+{
+    requestedFftOrder.store (juce::jlimit (minFftOrder, maxFftOrder, order));
+}
+
+AnalysisEngine::~AnalysisEngine()
+{
+    delete pendingLayout.exchange (nullptr);
+    delete retiredLayout.exchange (nullptr);
+}
+
+void AnalysisEngine::prepare (double sampleRate, int maximumBlockSize)
+{
+    const juce::ScopedLock sl (layoutBuildLock);
+
+    currentSampleRate = sampleRate;
+
+    // Half a second of audio (and never less than a few blocks) so a briefly
+    // descheduled analysis thread doesn't make the audio thread drop samples.
+    // Sized for the largest FFT, so changing the order never touches it.
+    const auto ringSize = juce::jmax ((1 << maxFftOrder) * 4,
+                                      maximumBlockSize * 4,
+                                      juce::roundToInt (sampleRate * 0.5));
+
+    sampleFifo.setTotalSize (ringSize + 1);
+
+    numPreparedChannels = juce::jlimit (0, maxChannels, channelLayout.size());
+    correlationPairs = ChannelLayoutInfo::getCorrelationPairs (channelLayout, AnalysisFrame::maxCorrelationPairs);
+
+    std::vector<float> loudnessWeights;
+
+    for (int ch = 0; ch < numPreparedChannels; ++ch)
+        loudnessWeights.push_back (ChannelLayoutInfo::getLoudnessWeight (channelLayout.getTypeOfChannel (ch)));
+
+    multichannelMeter.prepare (numPreparedChannels, correlationPairs);
+    truePeakMeter.prepare (numPreparedChannels, truePeakOversampling);
+    loudnessMeter.prepare (sampleRate, loudnessWeights);
+    setDownmixMatrix (downmixMatrix);
+    sampleRingLeft.assign ((size_t) sampleFifo.getTotalSize(), 0.0f);
+    sampleRingRight.assign ((size_t) sampleFifo.getTotalSize(), 0.0f);
+
+    spectrogram.setNumRows (spectrogramRows);
+    goniometer.prepare (sampleRate);
+
+    // Nothing is running, so the layout can be replaced directly
+    delete pendingLayout.exchange (nullptr);
+    delete retiredLayout.exchange (nullptr);
+
+    builtSettings = getSpectrumSettings();
+    layout = std::make_unique<SpectrumLayout> (builtSettings, sampleRate, spectrogram.getNumRows());
+    layoutPrepared = true;
+    filterBankSmoothingSeconds = -1.0;
+
+    activeFftOrder.store (layout->fftOrder);
+    activeNumBands.store (layout->numBands);
+    activeNumStages.store ((int) layout->stages.size());
+
+    reset();
+}
+
+AnalysisEngine::SpectrumLayout::SpectrumLayout (const SpectrumSettings& settings, double sampleRate, int numSpectrogramRows)
+    : fftOrder (juce::jlimit (minFftOrder, maxFftOrder, settings.fftOrder)),
+      fftSize (1 << fftOrder),
+      numBands (juce::jlimit (1, maxSpectrumBands, settings.numBands)),
+      fft (fftOrder)
+{
+    using WindowingFunction = juce::dsp::WindowingFunction<float>;
+
+    const auto method = [&]
+    {
+        switch (settings.window)
+        {
+            case Window::hamming:           return WindowingFunction::hamming;
+            case Window::blackman:          return WindowingFunction::blackman;
+            case Window::blackmanHarris:    return WindowingFunction::blackmanHarris;
+            case Window::flatTop:           return WindowingFunction::flatTop;
+            case Window::hann:              break;
+        }
+
+        return WindowingFunction::hann;
+    }();
+
+    windowTable.resize ((size_t) fftSize);
+    WindowingFunction::fillWindowingTables (windowTable.data(), (size_t) fftSize, method, false);
+
+    // Every window is scaled to the Hann window's coherent gain, (N - 1) / 2 for
+    // the symmetric table, so a tone reads the same whichever is chosen
+    const auto windowSum = std::accumulate (windowTable.begin(), windowTable.end(), 0.0);
+    juce::FloatVectorOperations::multiply (windowTable.data(), (float) ((fftSize - 1) * 0.5 / windowSum), fftSize);
+
+    for (auto& viewMagnitudes : magnitudes)
+        viewMagnitudes.resize ((size_t) fftSize / 2, 0.0f);
+
+    averageMagnitudes.resize ((size_t) fftSize / 2, 0.0f);
+
+    // The bands decide how deep the cascade goes
+    int numStages = 1;
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        const auto stage = getCascadeStage (getLogBandEdge (band, numBands), getLogBandEdge (band + 1, numBands), sampleRate, fftSize);
+
+        bandStages[(size_t) band] = stage;
+        numStages = juce::jmax (numStages, stage + 1);
+    }
+
+    spectrogramRowStages.resize ((size_t) numSpectrogramRows);
+
+    for (int row = 0; row < numSpectrogramRows; ++row)
+        spectrogramRowStages[(size_t) row] = juce::jmin (numStages - 1, getCascadeStage (getLogBandEdge (row, numSpectrogramRows),
+                                                                                           getLogBandEdge (row + 1, numSpectrogramRows),
+                                                                                           sampleRate, fftSize));
+
+    spectrogramMagnitudes.assign ((size_t) numSpectrogramRows, 0.0f);
+    spectrogramColumn.assign ((size_t) numSpectrogramRows, 0.0f);
+
+    stages.resize ((size_t) numStages);
+
+    for (int i = 0; i < numStages; ++i)
+    {
+        auto& stage = stages[(size_t) i];
+        stage.sampleRate = sampleRate / (double) (1 << i);
+        stage.fifoLeft.assign ((size_t) fftSize, 0.0f);
+        stage.fifoRight.assign ((size_t) fftSize, 0.0f);
+        stage.decimatedLeft.assign ((size_t) maxChunkSize / 2 + 1, 0.0f);
+        stage.decimatedRight.assign ((size_t) maxChunkSize / 2 + 1, 0.0f);
+        stage.bandMap.build (stage.sampleRate, fftSize, numBands, minSpectrumFrequency, maxSpectrumFrequency);
+        stage.spectrogramMap.build (stage.sampleRate, fftSize, numSpectrogramRows, minSpectrumFrequency, maxSpectrumFrequency);
+
+        for (auto& statistics : stage.statistics)
+            statistics.prepare (fftSize / 2);
+    }
+
+    if (settings.analyzer == Analyzer::filterBank)
+    {
+        std::vector<double> bandEdges;
+
+        for (int edge = 0; edge <= numBands; ++edge)
+            bandEdges.push_back (getLogBandEdge (edge, numBands));
+
+        filterBank = std::make_unique<FractionalOctaveFilterBank>();
+        filterBank->prepare (sampleRate, bandEdges);
+    }
+}
+
+void AnalysisEngine::SpectrumLayout::reset() noexcept
+{
+    for (auto& stage : stages)
+    {
+        std::fill (stage.fifoLeft.begin(), stage.fifoLeft.end(), 0.0f);
+        std::fill (stage.fifoRight.begin(), stage.fifoRight.end(), 0.0f);
+        stage.fifoIndex = 0;
+        stage.samplesToSkip = 0;
+        stage.decimatorLeft.reset();
+        stage.decimatorRight.reset();
+    }
+
+    for (auto& viewMagnitudes : magnitudes)
+        std::fill (viewMagnitudes.begin(), viewMagnitudes.end(), 0.0f);
+
+    std::fill (spectrogramColumn.begin(), spectrogramColumn.end(), 0.0f);
+
+    if (filterBank != nullptr)
+        filterBank->reset();
+}
+
+void AnalysisEngine::reset() noexcept
+{
+    sampleFifo.reset();
+    statsFifo.reset();
+    truePeakMeter.reset();
+    loudnessMeter.reset();
+    pendingStats = {};
+    meterSinceLastFrame = {};
+
+    analysedSamplePosition = 0;
+
+    if (layout != nullptr)
+        layout->reset();
+
+    spectrogram.reset();
+    goniometer.reset();
+
+    spectrumStatisticsResetPending.store (false);
+    resetSpectrumStatisticsNow();
+
+    // The loudness integration deliberately survives this, so it can run across
+    // transport restarts and be restored from a saved session
+    currentFrame = {};
+    currentFrame.numChannels = numPreparedChannels;
+    currentFrame.numSpectrumBands = layout != nullptr ? layout->numBands : maxSpectrumBands;
+    currentFrame.numCorrelationPairs = (int) correlationPairs.size();
+
+    for (size_t pair = 0; pair < correlationPairs.size(); ++pair)
+        currentFrame.correlationChannels[pair] = { correlationPairs[pair].first, correlationPairs[pair].second };
+
+    loudnessHistogramVersion = loudnessMeter.getHistogramVersion();
+    currentFrame.integratedLoudness = loudnessMeter.getIntegratedLoudness();
+    currentFrame.loudnessRange = loudnessMeter.getLoudnessRange();
+
+    spectrumChanged = false;
+    publishFrame();
+}
+
+//==============================================================================
+template <typename SampleType>
+void AnalysisEngine::pushBlock (const SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    numChannels = juce::jmin (numChannels, numPreparedChannels);
+
+    // Hand the downmix to the analysis side; if it has fallen behind, the
+    // samples that don't fit are still metered but dropped from the ring
+    // rather than blocking the callback
+    const auto scope = sampleFifo.write (numSamples);
+
+    BlockStats stats;
+    stats.numSamples = numSamples;
+    stats.numChannels = numChannels;
+
+    if (numChannels == 0)
+    {
+        scope.forEach ([this] (int index)
+        {
+            sampleRingLeft[(size_t) index]  = 0.0f;
+            sampleRingRight[(size_t) index] = 0.0f;
+        });
+    }
+    else
+    {
+        meterChannels (channels, numChannels, numSamples, stats);
+        truePeakMeter.process (channels, numChannels, numSamples, stats.truePeaks.data());
+        loudnessMeter.process (channels, numChannels, numSamples);
+
+        const auto& downmix = downmixMatrices.read();
+
+        auto writeDownmix = [&] (int ringIndex, int sourceOffset, int length)
+        {
+            downmixToRing (sampleRingLeft.data() + ringIndex, channels, numChannels, downmix.gains[0], sourceOffset, length);
+            downmixToRing (sampleRingRight.data() + ringIndex, channels, numChannels, downmix.gains[1], sourceOffset, length);
+        };
+
+        writeDownmix (scope.startIndex1, 0, scope.blockSize1);
+        writeDownmix (scope.startIndex2, scope.blockSize1, scope.blockSize2);
+    }
+
+    stats.momentaryLoudness = loudnessMeter.getMomentaryLoudness();
+    stats.shortTermLoudness = loudnessMeter.getShortTermLoudness();
+
+    pendingStats.merge (stats);
+
+    if (statsFifo.getFreeSpace() > 0)
+    {
+        const auto statsScope = statsFifo.write (1);
+        statsQueue[(size_t) statsScope.startIndex1] = pendingStats;
+        pendingStats = {};
+    }
+}
+
+template <typename SampleType>
+void AnalysisEngine::downmixToRing (float* destination, const SampleType* const* channels, int numChannels,
+                                    const std::array<float, maxChannels>& gains, int sourceOffset, int length) noexcept
+{
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        juce::FloatVectorOperations::copyWithMultiply (destination, channels[0] + sourceOffset, gains[0], length);
+
+        for (int ch = 1; ch < numChannels; ++ch)
+            if (gains[(size_t) ch] != 0.0f)
+                juce::FloatVectorOperations::addWithMultiply (destination, channels[ch] + sourceOffset, gains[(size_t) ch], length);
+    }
+    else
+    {
+        // Mixed in double a chunk at a time on the stack, then narrowed into the ring
+        constexpr int chunkLength = 256;
+        double mix[chunkLength];
+
+        for (int offset = 0; offset < length; offset += chunkLength)
+        {
+            const auto numToMix = juce::jmin (chunkLength, length - offset);
+            const auto start = sourceOffset + offset;
+
+            juce::FloatVectorOperations::copyWithMultiply (mix, channels[0] + start, (double) gains[0], numToMix);
+
+            for (int ch = 1; ch < numChannels; ++ch)
+                if (gains[(size_t) ch] != 0.0f)
+                    juce::FloatVectorOperations::addWithMultiply (mix, channels[ch] + start, (double) gains[(size_t) ch], numToMix);
+
+            for (int i = 0; i < numToMix; ++i)
+                destination[offset + i] = (float) mix[i];
+        }
+    }
+}
+
+template <typename SampleType>
+void AnalysisEngine::meterChannels (const SampleType* const* channels, int numChannels, int numSamples, BlockStats& stats) noexcept
+{
+    // The fused stereo kernels are float only; double stereo goes through the
+    // multichannel meter, which narrows as it transposes
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        if (numPreparedChannels <= 2)
+        {
+            // A mono input runs as L == R and only the left half is kept
+            StereoMeterStats stereo;
+            meterKernel (channels[0], channels[numChannels > 1 ? 1 : 0], nullptr, numSamples, stereo);
+
+            stats.meter.sumSquares[0] = stereo.sumSquaresLeft;
+            stats.meter.peaks[0] = stereo.peakLeft;
+
+            if (numChannels > 1)
+            {
+                stats.meter.sumSquares[1] = stereo.sumSquaresRight;
+                stats.meter.peaks[1] = stereo.peakRight;
+                stats.meter.sumCross[0] = stereo.sumCross;
+            }
+
+            return;
+        }
+    }
+
+    multichannelMeter.process (channels, numChannels, numSamples, stats.meter);
+}
+
+template void AnalysisEngine::pushBlock<float>  (const float* const*, int, int) noexcept;
+template void AnalysisEngine::pushBlock<double> (const double* const*, int, int) noexcept;
+
+void AnalysisEngine::processPendingSamples (int frameRateDivider) noexcept
+{
+    swapInPendingLayout();
+
+    if (layout == nullptr)
+        return;
+
+    hopMultiplier = juce::jmax (1, frameRateDivider);
+
+    if (const auto smoothing = bandSmoothing.load (std::memory_order_relaxed); smoothing != frameSmoothing)
+    {
+        frameSmoothing = smoothing;
+        smoothingSeconds = getSmoothingSeconds (smoothing);
+    }
+
+    frameMinDecibels = minDecibels.load (std::memory_order_relaxed);
+    frameMaxDecibels = maxDecibels.load (std::memory_order_relaxed);
+
+    if (spectrumStatisticsResetPending.exchange (false))
+        resetSpectrumStatisticsNow();
+
+    // Meter sums first, then the samples; a block's sums can show up one call before
+    // its samples, which only shifts the meters against the bands by that block
+    const auto statsScope = statsFifo.read (statsFifo.getNumReady());
+
+    statsScope.forEach ([this] (int index) { meterSinceLastFrame.merge (statsQueue[(size_t) index]); });
+
+    const auto scope = sampleFifo.read (sampleFifo.getNumReady());
+
+    auto pushRegion = [this] (int start, int numSamples)
+    {
+        goniometer.push (sampleRingLeft.data() + start, sampleRingRight.data() + start, numSamples);
+
+        for (int offset = 0; offset < numSamples; offset += maxChunkSize)
+        {
+            const auto* left = sampleRingLeft.data() + start + offset;
+            const auto* right = sampleRingRight.data() + start + offset;
+            const auto numInChunk = juce::jmin (maxChunkSize, numSamples - offset);
+
+            // Ahead of the FFT, so every frame it reports carries the bands as of its last sample
+            if (layout->filterBank != nullptr)
+                processFilterBank (left, right, numInChunk);
+
+            pushSamplesIntoStage (0, left, right, numInChunk);
+        }
+    };
+
+    pushRegion (scope.startIndex1, scope.blockSize1);
+    pushRegion (scope.startIndex2, scope.blockSize2);
+
+    if (spectrumChanged || meterSinceLastFrame.numSamples > 0
+         || loudnessMeter.getHistogramVersion() != loudnessHistogramVersion)
+        publishFrame();
+}
+
+void AnalysisEngine::publishFrame() noexcept
+{
+    auto& frame = currentFrame;
+    const auto& stats = meterSinceLastFrame;
+
+    frame.samplePosition = analysedSamplePosition;
+    frame.numMeteredSamples = stats.numSamples;
+
+    if (stats.numSamples > 0)
+    {
+        // Channels the blocks didn't have read as silent
+        for (size_t ch = 0; ch < (size_t) maxChannels; ++ch)
+        {
+            frame.rmsLevels[ch]  = static_cast<float> (std::sqrt (stats.meter.sumSquares[ch] / stats.numSamples));
+            frame.peakLevels[ch] = stats.meter.peaks[ch];
+            frame.truePeakLevels[ch] = stats.truePeaks[ch];
+        }
+
+        for (int pair = 0; pair < frame.numCorrelationPairs; ++pair)
+        {
+            const auto& channels = frame.correlationChannels[(size_t) pair];
+            const auto denom = std::sqrt (stats.meter.sumSquares[(size_t) channels[0]] * stats.meter.sumSquares[(size_t) channels[1]]);
+            frame.correlations[(size_t) pair] = static_cast<float> ((denom > 0.0) ? juce::jlimit (-1.0, 1.0, stats.meter.sumCross[(size_t) pair] / denom) : 0.0);
+        }
+
+        frame.momentaryLoudness = stats.momentaryLoudness;
+        frame.shortTermLoudness = stats.shortTermLoudness;
+    }
+
+    // Gating scans the histograms, so only redo it when a new block went in
+    if (const auto version = loudnessMeter.getHistogramVersion(); version != loudnessHistogramVersion)
+    {
+        loudnessHistogramVersion = version;
+        frame.integratedLoudness = loudnessMeter.getIntegratedLoudness();
+        frame.loudnessRange = loudnessMeter.getLoudnessRange();
+    }
+
+    const bool restartHold = truePeakHoldResetPending.exchange (false);
+
+    for (size_t ch = 0; ch < (size_t) maxChannels; ++ch)
+        frame.truePeakHoldLevels[ch] = restartHold ? frame.truePeakLevels[ch]
+                                                   : juce::jmax (frame.truePeakHoldLevels[ch], frame.truePeakLevels[ch]);
+
+    publishedFrames.getWriteBuffer() = frame;
+    publishedFrames.publish();
+
+    if (onFramePublished != nullptr)
+        onFramePublished (frame);
+
+    meterSinceLastFrame = {};
+    spectrumChanged = false;
+}
+
+void AnalysisEngine::BlockStats::merge (const BlockStats& other) noexcept
+{
+    for (size_t ch = 0; ch < (size_t) maxChannels; ++ch)
+    {
+        meter.sumSquares[ch] += other.meter.sumSquares[ch];
+        meter.peaks[ch] = juce::jmax (meter.peaks[ch], other.meter.peaks[ch]);
+        truePeaks[ch] = juce::jmax (truePeaks[ch], other.truePeaks[ch]);
+    }
+
+    for (size_t pair = 0; pair < meter.sumCross.size(); ++pair)
+        meter.sumCross[pair] += other.meter.sumCross[pair];
+
+    momentaryLoudness = other.momentaryLoudness;
+    shortTermLoudness = other.shortTermLoudness;
+
+    numSamples += other.numSamples;
+    numChannels = juce::jmax (numChannels, other.numChannels);
+}
+
+//==============================================================================
+void AnalysisEngine::setChannelLayout (const juce::AudioChannelSet& newLayout)
+{
+    if (newLayout == channelLayout)
+        return;
+
+    channelLayout = newLayout;
+    downmixMatrix = ChannelLayoutInfo::getDefaultDownmix (newLayout);
+}
+
+void AnalysisEngine::setDownmixMatrix (const DownmixMatrix& newMatrix) noexcept
+{
+    downmixMatrix = newMatrix;
+    downmixMatrices.getWriteBuffer() = newMatrix;
+    downmixMatrices.publish();
+}
+
+//==============================================================================
+void AnalysisEngine::setSpectrumPeakHold (float holdSeconds, float decayDbPerSecond) noexcept
+{
+    peakHoldSeconds.store (holdSeconds);
+    peakDecayDbPerSecond.store (decayDbPerSecond);
+}
+
+void AnalysisEngine::setSpectrumAverageWindow (double seconds) noexcept
+{
+    averageWindowSeconds.store (juce::jmax (0.0, seconds));
+    spectrumStatisticsResetPending.store (true);
+}
+
+void AnalysisEngine::resetSpectrumStatisticsNow() noexcept
+{
+    const auto window = averageWindowSeconds.load();
+
+    if (layout != nullptr)
+    {
+        for (auto& stage : layout->stages)
+        {
+            for (auto& statistics : stage.statistics)
+            {
+                statistics.reset();
+                statistics.setAverageWindow (window);
+            }
+        }
+    }
+
+    for (auto* levels : { &currentFrame.peakBandLevels, &currentFrame.averageBandLevels })
+        for (auto& viewLevels : *levels)
+            viewLevels.fill (0.0f);
+
+    currentFrame.spectrumAverageSeconds = 0.0;
+}
+
+//==============================================================================
+void AnalysisEngine::setSpectrumSettings (const SpectrumSettings& newSettings) noexcept
+{
+    // A range narrower than 1 dB would divide by (almost) nothing
+    const auto floor = juce::jlimit (-200.0f, 0.0f, newSettings.minDecibels);
+
+    bandSmoothing.store (juce::jlimit (0.0f, 0.99f, newSettings.smoothing));
+    minDecibels.store (floor);
+    maxDecibels.store (juce::jmax (floor + 1.0f, newSettings.maxDecibels));
+
+    const auto fftOrder = juce::jlimit (minFftOrder, maxFftOrder, newSettings.fftOrder);
+    const auto numBands = juce::jlimit (1, maxSpectrumBands, newSettings.numBands);
+
+    // Only these need a new layout; smoothing and range changes are picked up per frame
+    bool layoutChanged = false;
+    layoutChanged |= requestedFftOrder.exchange (fftOrder) != fftOrder;
+    layoutChanged |= requestedAnalyzer.exchange ((int) newSettings.analyzer) != (int) newSettings.analyzer;
+    layoutChanged |= requestedWindow.exchange ((int) newSettings.window) != (int) newSettings.window;
+    layoutChanged |= requestedNumBands.exchange (numBands) != numBands;
+
+    if (layoutChanged)
+        layoutUpdatePending.store (true, std::memory_order_release);
+}
+
+AnalysisEngine::SpectrumSettings AnalysisEngine::getSpectrumSettings() const noexcept
+{
+    SpectrumSettings settings;
+    settings.analyzer = (Analyzer) requestedAnalyzer.load();
+    settings.fftOrder = requestedFftOrder.load();
+    settings.window = (Window) requestedWindow.load();
+    settings.numBands = requestedNumBands.load();
+    settings.smoothing = bandSmoothing.load();
+    settings.minDecibels = minDecibels.load();
+    settings.maxDecibels = maxDecibels.load();
+    return settings;
+}
+
+bool AnalysisEngine::updateSpectrumLayout()
+{
+    const juce::ScopedLock sl (layoutBuildLock);
+
+    // Cleared before the settings are read, so a change made meanwhile asks again
+    layoutUpdatePending.store (false, std::memory_order_relaxed);
+    delete retiredLayout.exchange (nullptr);
+
+    // Not prepared yet: prepare() builds the first one
+    if (! layoutPrepared)
+        return false;
+
+    const auto settings = getSpectrumSettings();
+
+    if (settings.analyzer == builtSettings.analyzer && settings.fftOrder == builtSettings.fftOrder
+         && settings.window == builtSettings.window && settings.numBands == builtSettings.numBands)
+        return false;
+
+    builtSettings = settings;
+
+    // The spectrogram keeps the row count it was prepared with; changing that clears its buffer
+    auto next = std::make_unique<SpectrumLayout> (settings, currentSampleRate, spectrogram.getNumRows());
+
+    // One that hasn't been picked up yet is simply superseded
+    delete pendingLayout.exchange (next.release());
+    return true;
+}
+
+void AnalysisEngine::swapInPendingLayout() noexcept
+{
+    // Wait until the previous one has been freed, so nothing is ever deleted here
+    if (retiredLayout.load() != nullptr || pendingLayout.load (std::memory_order_relaxed) == nullptr)
+        return;
+
+    std::unique_ptr<SpectrumLayout> next (pendingLayout.exchange (nullptr));
+
+    if (next == nullptr)
+        return;
+
+    // The new layout starts empty: the bands rise again over its first frames, and
+    // the statistics start over at the new resolution
+    retiredLayout.store (layout.release());
+    layout = std::move (next);
+    filterBankSmoothingSeconds = -1.0;
+
+    for (auto& viewLevels : currentFrame.spectrumBandLevels)
+        viewLevels.fill (0.0f);
+
+    currentFrame.numSpectrumBands = layout->numBands;
+    resetSpectrumStatisticsNow();
+    spectrumChanged = true;
+
+    activeFftOrder.store (layout->fftOrder);
+    activeNumBands.store (layout->numBands);
+    activeNumStages.store ((int) layout->stages.size());
+
+    // So the old one gets freed
+    layoutUpdatePending.store (true, std::memory_order_release);
+}
+
+//==============================================================================
+void AnalysisEngine::setOverlap (Overlap newOverlap) noexcept
+{
+    overlap.store ((int) newOverlap);
+}
+
+AnalysisEngine::Overlap AnalysisEngine::getOverlap() const noexcept
+{
+    return (Overlap) overlap.load();
+}
+
+double AnalysisEngine::getSpectrumBandCentreFrequency (int bandIndex, int numBands)
+{
+    return std::sqrt (getLogBandEdge (bandIndex, numBands) * getLogBandEdge (bandIndex + 1, numBands));
+}
+
+double AnalysisEngine::getLogBandEdge (int edgeIndex, int numBands)
+{
+    const double logMin = std::log10 (minSpectrumFrequency);
+    const double logMax = std::log10 (maxSpectrumFrequency);
+
+    return std::pow (10.0, logMin + (logMax - logMin) * (static_cast<double> (edgeIndex) / numBands));
+}
+
+int AnalysisEngine::getCascadeStage (double lowEdge, double highEdge, double sampleRate, int fftSize)
+{
+    // The fastest stage whose bins are no wider than the band, as long as the
+    // band stays inside that stage's alias-free range
+    int stage = 0;
+
+    while (stage + 1 < maxCascadeStages
+           && sampleRate / (double) (fftSize << stage) > highEdge - lowEdge
+           && highEdge < 0.35 * sampleRate / (double) (2 << stage))
+    {
+        ++stage;
+    }
+
+    return stage;
+}
+
+float AnalysisEngine::getNormalisedLevel (float magnitude) const noexcept
+{
+    const float dbValue = juce::Decibels::gainToDecibels (magnitude, frameMinDecibels - 20.0f);
+    return juce::jlimit (0.0f, 1.0f, juce::jmap (dbValue, frameMinDecibels, frameMaxDecibels, 0.0f, 1.0f));
+}
+
+double AnalysisEngine::getSmoothingSeconds (float smoothing) noexcept
+{
+    // The setting is what carries over per 20 ms, about one frame at the default FFT size
+    return smoothing > 0.0f ? -0.02 / std::log ((double) smoothing) : 0.0;
+}
+
+//==============================================================================
+int AnalysisEngine::getHopSize() const noexcept
+{
+    const auto fftSize = layout->fftSize;
+
+    switch (getOverlap())
+    {
+        case Overlap::threeQuarters:  return hopMultiplier * fftSize / 4;
+        case Overlap::sevenEighths:   return hopMultiplier * fftSize / 8;
+        case Overlap::half:           break;
+    }
+
+    return hopMultiplier * fftSize / 2;
+}
+
+void AnalysisEngine::pushSamplesIntoStage (int stageIndex, const float* left, const float* right, int numSamples) noexcept
+{
+    auto& stages = layout->stages;
+    auto& stage = stages[(size_t) stageIndex];
+    const bool hasNextStage = stageIndex + 1 < (int) stages.size();
+    const auto fftSize = layout->fftSize;
+
+    int numDecimated = 0;
+
+    if (hasNextStage)
+    {
+        numDecimated = stage.decimatorLeft.process (left, numSamples, stage.decimatedLeft.data());
+        stage.decimatorRight.process (right, numSamples, stage.decimatedRight.data());
+    }
+
+    if (stageIndex == 0)
+        analysedSamplePosition += numSamples;
+
+    while (numSamples > 0)
+    {
+        if (stage.samplesToSkip > 0)
+        {
+            const auto numToSkip = juce::jmin (numSamples, stage.samplesToSkip);
+            left                += numToSkip;
+            right               += numToSkip;
+            numSamples          -= numToSkip;
+            stage.samplesToSkip -= numToSkip;
+            continue;
+        }
+
+        const auto numToCopy = juce::jmin (numSamples, fftSize - stage.fifoIndex);
+
+        std::copy (left,  left  + numToCopy, stage.fifoLeft.begin()  + stage.fifoIndex);
+        std::copy (right, right + numToCopy, stage.fifoRight.begin() + stage.fifoIndex);
+        stage.fifoIndex += numToCopy;
+        left            += numToCopy;
+        right           += numToCopy;
+        numSamples      -= numToCopy;
+
+        if (stage.fifoIndex == fftSize)
+        {
+            performFFTAnalysis (stageIndex);
+
+            // Keep the tail of this frame as the head of the next one, or skip
+            // ahead if the hop has been stretched past the frame
+            const auto hopSize = getHopSize();
+
+            if (hopSize < fftSize)
+            {
+                std::copy (stage.fifoLeft.begin()  + hopSize, stage.fifoLeft.end(),  stage.fifoLeft.begin());
+                std::copy (stage.fifoRight.begin() + hopSize, stage.fifoRight.end(), stage.fifoRight.begin());
+                stage.fifoIndex = fftSize - hopSize;
+            }
+            else
+            {
+                stage.fifoIndex = 0;
+                stage.samplesToSkip = hopSize - fftSize;
+            }
+        }
+    }
+
+    if (numDecimated > 0)
+        pushSamplesIntoStage (stageIndex + 1, stage.decimatedLeft.data(), stage.decimatedRight.data(), numDecimated);
+}
+
+void AnalysisEngine::performFFTAnalysis (int stageIndex) noexcept
+{
+    auto& stage = layout->stages[(size_t) stageIndex];
+    const auto fftSize = layout->fftSize;
+    const auto& windowTable = layout->windowTable;
+    auto* fftInput = layout->fft.getInput();
+    const auto* fftOutput = layout->fft.getOutput();
+    auto& magnitudes = layout->magnitudes;
+
+    // Each frame stands for one hop of this stage's input
+    const auto frameSeconds = (double) getHopSize() / stage.sampleRate;
+    const LoadProfiler::ScopedTimer timer (profiler, LoadProfiler::Section::fftFrame, frameSeconds);
+
+    // Two real signals in one complex transform: z = l + i*r
+    for (size_t i = 0; i < (size_t) fftSize; ++i)
+        fftInput[i] = { stage.fifoLeft[i] * windowTable[i], stage.fifoRight[i] * windowTable[i] };
+
+    layout->fft.perform();
+
+    // Separate them again using the conjugate symmetry of real spectra:
+    // L[k] = (Z[k] + conj Z[N-k]) / 2,  R[k] = (Z[k] - conj Z[N-k]) / 2i
+    // Mid and side are linear in L and R, so they come for free.
+    const int numMagnitudes = fftSize / 2;
+    const auto scale = 1.0f / static_cast<float> (fftSize);
+
+    auto& midMagnitudes   = magnitudes[(size_t) SpectrumView::mid];
+    auto& leftMagnitudes  = magnitudes[(size_t) SpectrumView::left];
+    auto& rightMagnitudes = magnitudes[(size_t) SpectrumView::right];
+    auto& sideMagnitudes  = magnitudes[(size_t) SpectrumView::side];
+
+    for (int bin = 1; bin < numMagnitudes; ++bin)
+    {
+        const auto z          = fftOutput[(size_t) bin];
+        const auto zMirrored  = std::conj (fftOutput[(size_t) (fftSize - bin)]);
+
+        const auto l = (z + zMirrored) * 0.5f;
+        const auto r = (z - zMirrored) * juce::dsp::Complex<float> (0.0f, -0.5f);
+
+        leftMagnitudes[(size_t) bin]  = std::abs (l) * scale;
+        rightMagnitudes[(size_t) bin] = std::abs (r) * scale;
+        midMagnitudes[(size_t) bin]   = std::abs ((l + r) * 0.5f) * scale;
+        sideMagnitudes[(size_t) bin]  = std::abs ((l - r) * 0.5f) * scale;
+    }
+
+    // The same ballistics on every stage, whatever its frame rate
+    const auto carryOver = smoothingSeconds > 0.0 ? (float) std::exp (-frameSeconds / smoothingSeconds) : 0.0f;
+
+    const auto holdSeconds = peakHoldSeconds.load (std::memory_order_relaxed);
+    const auto decayDbPerSecond = peakDecayDbPerSecond.load (std::memory_order_relaxed);
+
+    for (int view = 0; view < numSpectrumViews; ++view)
+    {
+        auto& statistics = stage.statistics[(size_t) view];
+        statistics.setPeakHold (holdSeconds, decayDbPerSecond);
+        statistics.addFrame (magnitudes[(size_t) view].data(), frameSeconds);
+
+        updateSpectrumBands (stageIndex, (SpectrumView) view, magnitudes[(size_t) view].data(), carryOver);
+        updateSpectrumStatistics (stageIndex, (SpectrumView) view);
+    }
+
+    if (stageIndex == 0)
+        currentFrame.spectrumAverageSeconds = stage.statistics[(size_t) SpectrumView::mid].getAverageSeconds();
+
+    updateSpectrogramColumn (stageIndex, midMagnitudes.data());
+
+    // Report once per input-rate frame; the lower stages' bands are picked up as they change
+    if (stageIndex == 0 && onSpectrumFrame != nullptr)
+    {
+        currentFrame.samplePosition = analysedSamplePosition;
+        onSpectrumFrame (currentFrame);
+    }
+}
+
+void AnalysisEngine::processFilterBank (const float* left, const float* right, int numSamples) noexcept
+{
+    static_assert (FractionalOctaveFilterBank::maxChunkSize >= maxChunkSize, "The ring is drained in chunks the filter bank takes whole");
+    static_assert (FractionalOctaveFilterBank::numViews == numSpectrumViews, "The filter bank computes every view");
+
+    auto& filterBank = *layout->filterBank;
+
+    if (smoothingSeconds != filterBankSmoothingSeconds)
+    {
+        filterBankSmoothingSeconds = smoothingSeconds;
+        filterBank.setIntegrationTime (smoothingSeconds);
+    }
+
+    filterBank.process (left, right, numSamples);
+
+    // The integrator is the ballistics, so the levels go out as they are
+    for (int view = 0; view < numSpectrumViews; ++view)
+    {
+        auto& levels = currentFrame.spectrumBandLevels[(size_t) view];
+        filterBank.getBandMagnitudes (view, bandMagnitudes.data());
+
+        for (int band = 0; band < layout->numBands; ++band)
+            levels[(size_t) band] = getNormalisedLevel (bandMagnitudes[(size_t) band]);
+    }
+
+    spectrumChanged = true;
+}
+
+void AnalysisEngine::updateSpectrumBands (int stageIndex, SpectrumView view, const float* viewMagnitudes, float carryOver) noexcept
+{
+    if (layout->filterBank != nullptr)
+        return;
+
+    layout->stages[(size_t) stageIndex].bandMap.apply (viewMagnitudes, bandMagnitudes.data());
+
+    auto& smoothed = currentFrame.spectrumBandLevels[(size_t) view];
+
+    for (int band = 0; band < layout->numBands; ++band)
+    {
+        if (layout->bandStages[(size_t) band] != stageIndex)
+            continue;
+
+        const float normalized = getNormalisedLevel (bandMagnitudes[(size_t) band]);
+
+        smoothed[(size_t) band] = carryOver * smoothed[(size_t) band] + (1.0f - carryOver) * normalized;
+        spectrumChanged = true;
+    }
+}
+
+void AnalysisEngine::updateSpectrumStatistics (int stageIndex, SpectrumView view) noexcept
+{
+    // The statistics are kept per bin; only what's shown gets reduced to bands
+    const auto& stage = layout->stages[(size_t) stageIndex];
+    const auto& statistics = stage.statistics[(size_t) view];
+    const auto& bandStages = layout->bandStages;
+    auto& averageMagnitudes = layout->averageMagnitudes;
+
+    auto& peakLevels = currentFrame.peakBandLevels[(size_t) view];
+    auto& averageLevels = currentFrame.averageBandLevels[(size_t) view];
+
+    stage.bandMap.apply (statistics.getPeakMagnitudes(), bandMagnitudes.data());
+
+    for (int band = 0; band < layout->numBands; ++band)
+        if (bandStages[(size_t) band] == stageIndex)
+            peakLevels[(size_t) band] = getNormalisedLevel (bandMagnitudes[(size_t) band]);
+
+    statistics.getAverageMagnitudes (averageMagnitudes.data());
+    stage.bandMap.apply (averageMagnitudes.data(), bandMagnitudes.data());
+
+    for (int band = 0; band < layout->numBands; ++band)
+        if (bandStages[(size_t) band] == stageIndex)
+            averageLevels[(size_t) band] = getNormalisedLevel (bandMagnitudes[(size_t) band]);
+}
+
+void AnalysisEngine::updateSpectrogramColumn (int stageIndex, const float* midMagnitudes) noexcept
+{
+    auto& spectrogramMagnitudes = layout->spectrogramMagnitudes;
+    auto& spectrogramColumn = layout->spectrogramColumn;
+
+    layout->stages[(size_t) stageIndex].spectrogramMap.apply (midMagnitudes, spectrogramMagnitudes.data());
+
+    // Unsmoothed, so the spectrogram keeps the frames' time resolution
+    // Sized by prepare(), which may have used a different row count than is set now
+    for (int row = 0; row < (int) spectrogramColumn.size(); ++row)
+    {
+        if (layout->spectrogramRowStages[(size_t) row] != stageIndex)
+            continue;
+
+        spectrogramColumn[(size_t) row] = getNormalisedLevel (spectrogramMagnitudes[(size_t) row]);
+    }
+
+    // One column per input-rate frame; slower stages' rows hold until they update
+    if (stageIndex == 0)
+        spectrogram.push (spectrogramColumn.data());
+}
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "SpectrumBandMap.h"
+#include "HalfBandDecimator.h"
+#include "ComplexFFT.h"
+#include "FractionalOctaveFilterBank.h"
+#include "StereoMeterKernel.h"
+#include "MultichannelMeter.h"
+#include "ChannelLayoutInfo.h"
+#include "TruePeakMeter.h"
+#include "LoudnessMeter.h"
+#include "SpectrogramBuffer.h"
+#include "GoniometerBuffer.h"
+#include "SpectrumStatistics.h"
+#include "AnalysisFrame.h"
+#include "TripleBuffer.h"
+#include "LoadProfiler.h"
+#include <atomic>
+#include <array>
+#include <vector>
+#include <functional>
+#include <memory>
+
+//==============================================================================
+/**
+    The plugin's metering and spectrum analysis, without any plugin or UI code.
+
+    The work is split between two sides:
+     - pushBlock() runs on the audio thread: it meters every channel of the
+       block (RMS, peak, true peak, pair correlations, loudness) and queues the
+       meter sums, and the block downmixed to left and right, in lock-free rings.
+     - processPendingSamples() runs on whatever thread drains those rings: it
+       slides the FFT window along by the overlap hop, updates the bands, and
+       publishes the meters and bands together as one AnalysisFrame.
+
+    Layouts up to 7.1.4 are metered per channel. The spectrum is taken from a
+    stereo downmix of the input, set by a DownmixMatrix.
+
+    Left and right are packed into the real and imaginary parts of a single
+    complex FFT and separated afterwards, so all four spectrum views
+    (mid, left, right, side) cost one complex transform per frame.
+
+    Low bands are too narrow for the input-rate FFT's bins, so the signal is
+    also run down a cascade of half-band decimators. Each stage halves the
+    rate and feeds an FFT of the same size, halving its bin width, and every
+    band reads from the fastest stage that resolves it. The stages below the
+    first run half as often as the one above, so the whole cascade costs less
+    than twice the single FFT. The number of stages follows the sample rate.
+
+    Every stage also keeps a peak hold and a long-term average of each view at
+    its own bin resolution (see SpectrumStatistics); they are reduced to bands
+    the same way as the spectrum.
+
+    The band levels can come from a bank of IIR band-pass filters instead (see
+    FractionalOctaveFilterBank), which follows the signal sample by sample
+    rather than a frame behind. The FFT cascade still runs alongside it for the
+    spectrogram, the peak hold and the long-term average.
+
+    The analyzer, FFT order, window and band count can change while running.
+    Everything they affect (the FFT, window table, cascade, band maps and
+    filter bank) is built by
+    updateSpectrumLayout() on a background thread and handed over whole, so
+    neither the audio thread nor the analysis side ever allocates for it.
+
+    Call both from the same thread for offline work. getLatestFrame() is meant
+    for a single reader thread, normally the message thread.
+*/
+class AnalysisEngine
+{
+public:
+    static constexpr int maxSpectrumBands = AnalysisFrame::maxSpectrumBands;
+    static constexpr int maxChannels = AnalysisFrame::maxChannels;
+    static constexpr int defaultFftOrder  = 11; // 2048 samples
+    static constexpr int minFftOrder = 10;
+    static constexpr int maxFftOrder = 14;
+
+    static constexpr double minSpectrumFrequency = 20.0;
+    static constexpr double maxSpectrumFrequency = 20000.0;
+
+    // How far consecutive FFT frames overlap; higher overlap = faster display refresh
+    enum class Overlap
+    {
+        half,
+        threeQuarters,
+        sevenEighths
+    };
+
+    using SpectrumView = AnalysisFrame::SpectrumView;
+    static constexpr int numSpectrumViews = AnalysisFrame::numSpectrumViews;
+
+    enum class Window
+    {
+        hann,
+        hamming,
+        blackman,
+        blackmanHarris,
+        flatTop
+    };
+
+    // Where the band levels come from
+    enum class Analyzer
+    {
+        fft,
+        filterBank
+    };
+
+    /** How the spectrum is computed and scaled. */
+    struct SpectrumSettings
+    {
+        Analyzer analyzer = Analyzer::fft;
+        int fftOrder = defaultFftOrder;
+        Window window = Window::hann;
+        int numBands = maxSpectrumBands;
+
+        float smoothing = 0.8f;         // how much of a band's level carries over per 20 ms, whatever the analyzer, stage or hop
+        float minDecibels = -80.0f;     // band levels map this range onto 0..1
+        float maxDecibels = 0.0f;
+    };
+
+    explicit AnalysisEngine (int fftOrder = defaultFftOrder);
+    ~AnalysisEngine();
+
+    /** Allocates the ring, FFT buffers and band map. Not realtime safe. */
+    void prepare (double sampleRate, int maximumBlockSize);
+
+    /** Clears all analysis state and meters without reallocating, and publishes
+        an empty frame. Don't call it while either side is running.
+    */
+    void reset() noexcept;
+
+    //==============================================================================
+    /** Audio thread: meters one block and queues it for analysis. SampleType is
+        float or double; the analysis side always runs in float, so double input
+        is narrowed once it has been metered and downmixed.
+    */
+    template <typename SampleType>
+    void pushBlock (const SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** Analysis side: consumes everything queued so far, running an FFT frame per hop,
+        then publishes a new frame if anything arrived.
+
+        A frameRateDivider above 1 stretches the hop that many times, so only one
+        frame in that many is computed; a caller that can't keep up uses it to
+        shed work rather than fall further behind.
+    */
+    void processPendingSamples (int frameRateDivider = 1) noexcept;
+
+    //==============================================================================
+    /** The input's layout, up to maxChannels. Takes effect on the next prepare(); a
+        new layout also brings back its default downmix. Stereo until set.
+    */
+    void setChannelLayout (const juce::AudioChannelSet& newLayout);
+    const juce::AudioChannelSet& getChannelLayout() const noexcept    { return channelLayout; }
+
+    /** How the input is mixed down to the pair the spectrum analyses. Applies from the
+        next block; call it from the thread that calls prepare().
+    */
+    void setDownmixMatrix (const DownmixMatrix& newMatrix) noexcept;
+    const DownmixMatrix& getDownmixMatrix() const noexcept            { return downmixMatrix; }
+
+    //==============================================================================
+    void setOverlap (Overlap newOverlap) noexcept;
+    Overlap getOverlap() const noexcept;
+
+    /** 4x meets BS.1770; 8x reads closer near Nyquist. Takes effect on the next prepare(). */
+    void setTruePeakOversampling (TruePeakMeter::Oversampling newOversampling) noexcept   { truePeakOversampling = newOversampling; }
+    TruePeakMeter::Oversampling getTruePeakOversampling() const noexcept                  { return truePeakOversampling; }
+
+    /** Restarts the true-peak hold from the next published frame. Any thread. */
+    void resetTruePeakHold() noexcept                   { truePeakHoldResetPending.store (true); }
+
+    /** Starts a new integrated loudness / loudness range measurement. Any thread. */
+    void resetLoudnessIntegration() noexcept            { loudnessMeter.resetIntegration(); }
+
+    /** The integrated loudness state, to be saved with the plugin's state. Any thread. */
+    void saveLoudnessIntegration (juce::MemoryBlock& destData) const        { loudnessMeter.saveIntegration (destData); }
+    bool restoreLoudnessIntegration (const void* data, size_t numBytes)     { return loudnessMeter.restoreIntegration (data, numBytes); }
+
+    //==============================================================================
+    /** Any thread; never locks or allocates, so automation can call it from the
+        audio thread. Smoothing and the dB range apply from the next frame; the
+        rest waits for updateSpectrumLayout() to build it.
+    */
+    void setSpectrumSettings (const SpectrumSettings& newSettings) noexcept;
+    SpectrumSettings getSpectrumSettings() const noexcept;
+
+    /** Background thread: builds a new layout if the analyzer, FFT order, window or band count
+        have changed, for the analysis side to swap in before its next frame, and
+        frees the one the last swap replaced. Returns true if it built one.
+    */
+    bool updateSpectrumLayout();
+
+    /** True once the analyzer, FFT order, window or band count change, or a swap leaves
+        a layout to free, until the next updateSpectrumLayout(). Any thread; a single
+        atomic load, so whoever builds layouts can check it as often as it likes.
+    */
+    bool isLayoutUpdatePending() const noexcept         { return layoutUpdatePending.load (std::memory_order_acquire); }
+
+    /** What the analysis side is running with right now. */
+    int getFftOrder() const noexcept                    { return activeFftOrder.load (std::memory_order_relaxed); }
+    int getFftSize() const noexcept                     { return 1 << getFftOrder(); }
+    int getNumSpectrumBands() const noexcept            { return activeNumBands.load (std::memory_order_relaxed); }
+    int getNumCascadeStages() const noexcept            { return activeNumStages.load (std::memory_order_relaxed); }
+
+    double getSampleRate() const noexcept               { return currentSampleRate; }
+
+    /** Reader side: the newest published frame, which stays unchanged until the
+        next call. Wait-free, but only one thread may read.
+    */
+    const AnalysisFrame& getLatestFrame() noexcept      { return publishedFrames.read(); }
+
+    static double getSpectrumBandCentreFrequency (int bandIndex, int numBands = maxSpectrumBands);
+
+    //==============================================================================
+    /** Per-bin peak hold: how long a peak stays before it starts to fall, and how
+        fast it falls. Any thread.
+    */
+    void setSpectrumPeakHold (float holdSeconds, float decayDbPerSecond) noexcept;
+
+    /** Length of the long-term average spectrum; 0 averages everything since the
+        last reset. Restarts the average and peaks. Any thread.
+    */
+    void setSpectrumAverageWindow (double seconds) noexcept;
+
+    /** Restarts the long-term average and the peak hold. Any thread. */
+    void resetSpectrumStatistics() noexcept             { spectrumStatisticsResetPending.store (true); }
+
+    //==============================================================================
+    /** Rows of the spectrogram (mid signal, log-spaced like the bands). Takes
+        effect on the next prepare().
+    */
+    void setSpectrogramRows (int numRows) noexcept      { spectrogramRows = juce::jlimit (SpectrogramBuffer::minRows, SpectrogramBuffer::maxRows, numRows); }
+    int getSpectrogramRows() const noexcept             { return spectrogramRows; }
+
+    /** One spectrogram column per input-rate FFT frame, for a single reader thread. */
+    SpectrogramBuffer& getSpectrogram() noexcept        { return spectrogram; }
+
+    /** Decimated pairs of the downmixed left/right signal, for a single reader thread. */
+    GoniometerBuffer& getGoniometer() noexcept          { return goniometer; }
+
+    /** Called after every input-rate FFT frame on the thread that calls
+        processPendingSamples(), with the bands as they stand after it. Its meters
+        are those of the last published frame. Set it before prepare().
+    */
+    std::function<void (const AnalysisFrame&)> onSpectrumFrame;
+
+    /** Called with every frame as it's published, on the same thread. It must not
+        block: when rendering offline that's the audio thread. Set it before prepare().
+    */
+    std::function<void (const AnalysisFrame&)> onFramePublished;
+
+    /** Timings of every FFT frame, and of whatever the owner records into it. */
+    LoadProfiler& getProfiler() noexcept                { return profiler; }
+    const LoadProfiler& getProfiler() const noexcept    { return profiler; }
+
+private:
+    double currentSampleRate { 44100.0 };
+
+    juce::AudioChannelSet channelLayout = juce::AudioChannelSet::stereo();
+    int numPreparedChannels = 2;
+    std::vector<ChannelLayoutInfo::ChannelPair> correlationPairs;
+
+    // Message thread -> audio thread
+    DownmixMatrix downmixMatrix = ChannelLayoutInfo::getDefaultDownmix (channelLayout);
+    TripleBuffer<DownmixMatrix> downmixMatrices;
+
+    // Single-producer (audio thread) / single-consumer (analysis side) ring of the
+    // downmix; both channels share the fifo's indices
+    juce::AbstractFifo sampleFifo { 1 };
+    std::vector<float> sampleRingLeft, sampleRingRight;
+
+    //==============================================================================
+    // One rung of the constant-Q cascade. Stage 0 runs at the input rate and each
+    // further stage at half the rate of the one above it.
+    struct CascadeStage
+    {
+        double sampleRate = 0.0;
+
+        std::vector<float> fifoLeft, fifoRight;
+        int fifoIndex = 0;
+        int samplesToSkip = 0; // when the hop is longer than a frame
+
+        SpectrumBandMap bandMap, spectrogramMap;
+
+        // Peak hold and long-term average per view, at this stage's bin resolution
+        std::array<SpectrumStatistics, AnalysisFrame::numSpectrumViews> statistics;
+
+        // Produce the next stage's input from this stage's
+        HalfBandDecimator decimatorLeft, decimatorRight;
+        std::vector<float> decimatedLeft, decimatedRight;
+    };
+
+    static constexpr int maxCascadeStages = 8;
+    static constexpr int maxChunkSize = 1024; // samples pushed down the cascade at once
+
+    // Everything that depends on the analyzer, FFT order, window or band count
+    struct SpectrumLayout
+    {
+        SpectrumLayout (const SpectrumSettings&, double sampleRate, int numSpectrogramRows);
+
+        void reset() noexcept;
+
+        const int fftOrder, fftSize, numBands;
+
+        ComplexFFT fft;
+        std::vector<float> windowTable;
+        std::array<std::vector<float>, numSpectrumViews> magnitudes;
+        std::vector<float> averageMagnitudes;
+
+        std::vector<CascadeStage> stages;
+        std::array<int, maxSpectrumBands> bandStages {};
+
+        // Spectrogram rows read from the cascade like the bands do, but never from a
+        // stage the bands don't already need
+        std::vector<int> spectrogramRowStages;
+        std::vector<float> spectrogramMagnitudes, spectrogramColumn;
+
+        // Only with Analyzer::filterBank, in which case the bands come from it alone
+        std::unique_ptr<FractionalOctaveFilterBank> filterBank;
+    };
+
+    // The analysis side owns `layout`. A replacement arrives in pendingLayout and the
+    // one it replaces leaves through retiredLayout, to be freed by the next
+    // updateSpectrumLayout(); a new one is only taken once the last has been freed.
+    std::unique_ptr<SpectrumLayout> layout;
+    std::atomic<SpectrumLayout*> pendingLayout { nullptr }, retiredLayout { nullptr };
+    juce::CriticalSection layoutBuildLock; // prepare() against updateSpectrumLayout()
+    std::atomic<bool> layoutUpdatePending { false };
+    SpectrumSettings builtSettings;
+    bool layoutPrepared = false; // so updateSpectrumLayout() never looks at `layout`
+
+    std::atomic<int> requestedAnalyzer { (int) Analyzer::fft };
+    std::atomic<int> requestedFftOrder { defaultFftOrder }, requestedWindow { (int) Window::hann };
+    std::atomic<int> requestedNumBands { maxSpectrumBands };
+    std::atomic<float> bandSmoothing { 0.8f }, minDecibels { -80.0f }, maxDecibels { 0.0f };
+    std::atomic<int> activeFftOrder { defaultFftOrder }, activeNumBands { maxSpectrumBands }, activeNumStages { 0 };
+
+    // Everything below is only touched by the analysis side
+    juce::int64 analysedSamplePosition { 0 };
+    std::array<float, maxSpectrumBands> bandMagnitudes {};
+    float frameSmoothing = -1.0f, frameMinDecibels = -80.0f, frameMaxDecibels = 0.0f;
+    double smoothingSeconds = 0.0; // frameSmoothing as a time constant
+    double filterBankSmoothingSeconds = -1.0; // what its integration time was last set to
+    int hopMultiplier = 1;
+
+    std::atomic<float> peakHoldSeconds { 1.0f }, peakDecayDbPerSecond { 12.0f };
+    std::atomic<double> averageWindowSeconds { 0.0 };
+    std::atomic<bool> spectrumStatisticsResetPending { false };
+
+    int spectrogramRows = SpectrogramBuffer::defaultRows;
+    SpectrogramBuffer spectrogram;
+
+    GoniometerBuffer goniometer;
+
+    std::atomic<int> overlap { (int) Overlap::half };
+
+    //==============================================================================
+    // Meter sums of one or more input blocks
+    struct BlockStats
+    {
+        MultichannelMeterStats meter;
+        std::array<float, maxChannels> truePeaks {};
+        float momentaryLoudness = LoudnessMeter::minLoudness; // as of the latest block
+        float shortTermLoudness = LoudnessMeter::minLoudness;
+        int numSamples = 0;
+        int numChannels = 0;
+
+        void merge (const BlockStats& other) noexcept;
+    };
+
+    static_assert (MultichannelMeter::maxChannels == maxChannels && LoudnessMeter::maxChannels == maxChannels
+                    && DownmixMatrix::maxChannels == maxChannels, "The meters must agree on the widest layout");
+    static_assert (MultichannelMeter::maxPairs == AnalysisFrame::maxCorrelationPairs, "One correlation per metered pair");
+
+    // Mono and stereo use the fused kernel, vectorised along time and resolved once
+    // per instance to the widest this CPU supports. Wider layouts put the channels
+    // in SIMD lanes instead.
+    const StereoMeterKernel::Function meterKernel = StereoMeterKernel::getBestImplementation();
+    MultichannelMeter multichannelMeter;
+
+    TruePeakMeter truePeakMeter; // audio thread
+    TruePeakMeter::Oversampling truePeakOversampling = TruePeakMeter::Oversampling::fourTimes;
+    std::atomic<bool> truePeakHoldResetPending { false };
+
+    LoudnessMeter loudnessMeter;
+    juce::uint32 loudnessHistogramVersion = 0; // analysis side: what the frame's gated values were computed from
+
+    // Audio thread -> analysis side. If the queue is full, the audio thread keeps
+    // adding to pendingStats until there's room, so no block goes unmetered.
+    static constexpr int statsQueueSize = 256;
+    juce::AbstractFifo statsFifo { statsQueueSize };
+    std::array<BlockStats, statsQueueSize> statsQueue {};
+    BlockStats pendingStats; // audio thread only
+
+    // The frame being built (analysis side), and the ones handed to the reader
+    AnalysisFrame currentFrame;
+    BlockStats meterSinceLastFrame;
+    bool spectrumChanged = false;
+    TripleBuffer<AnalysisFrame> publishedFrames;
+
+    LoadProfiler profiler;
+
+    void publishFrame() noexcept;
+
+    template <typename SampleType>
+    void meterChannels (const SampleType* const* channels, int numChannels, int numSamples, BlockStats& stats) noexcept;
+
+    template <typename SampleType>
+    static void downmixToRing (float* destination, const SampleType* const* channels, int numChannels,
+                               const std::array<float, maxChannels>& gains, int sourceOffset, int length) noexcept;
+
+    static double getLogBandEdge (int edgeIndex, int numBands);
+    static int getCascadeStage (double lowEdge, double highEdge, double sampleRate, int fftSize);
+    float getNormalisedLevel (float magnitude) const noexcept;
+    static double getSmoothingSeconds (float smoothing) noexcept;
+
+    void swapInPendingLayout() noexcept;
+
+    void pushSamplesIntoStage (int stageIndex, const float* left, const float* right, int numSamples) noexcept;
+    int getHopSize() const noexcept;
+    void performFFTAnalysis (int stageIndex) noexcept;
+    void processFilterBank (const float* left, const float* right, int numSamples) noexcept;
+    void updateSpectrumBands (int stageIndex, SpectrumView view, const float* viewMagnitudes, float carryOver) noexcept;
+    void updateSpectrumStatistics (int stageIndex, SpectrumView view) noexcept;
+    void resetSpectrumStatisticsNow() noexcept;
+    void updateSpectrogramColumn (int stageIndex, const float* midMagnitudes) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisEngine)
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+
+//==============================================================================
+/**
+    One coherent snapshot of everything the analyser shows: the meters and all
+    spectrum views, stamped with how far into the input stream it was taken.
+
+    It's a plain value, published as a whole by AnalysisEngine, so a reader
+    never sees bands from one FFT frame next to meters from another.
+*/
+struct AnalysisFrame
+{
+    static constexpr int maxSpectrumBands = 31;
+
+    // Which signal a spectrum is taken from; mid is the (L + R) / 2 mono mix
+    enum class SpectrumView
+    {
+        mid,
+        left,
+        right,
+        side
+    };
+
+    static constexpr int numSpectrumViews = 4;
+
+    static constexpr int maxChannels = 12; // 7.1.4
+    static constexpr int maxCorrelationPairs = 6;
+
+    //==============================================================================
+    /** Input samples analysed when the frame was published. */
+    juce::int64 samplePosition = 0;
+
+    /** The meters cover the input blocks that arrived since the previous frame;
+        0 means none did and the values are carried over from it.
+    */
+    int numMeteredSamples = 0;
+
+    /** Per-channel meters, in the input's channel order. */
+    int numChannels = 0;
+    std::array<float, maxChannels> rmsLevels {};
+    std::array<float, maxChannels> peakLevels {};
+
+    /** BS.1770 true peaks (linear) of the same blocks, and the highest since the
+        hold was last reset.
+    */
+    std::array<float, maxChannels> truePeakLevels {};
+    std::array<float, maxChannels> truePeakHoldLevels {};
+
+    /** Correlation of each mirrored channel pair in the layout (front left/right
+        first), with the two channels' indices.
+    */
+    int numCorrelationPairs = 0;
+    std::array<float, maxCorrelationPairs> correlations {};
+    std::array<std::array<int, 2>, maxCorrelationPairs> correlationChannels {};
+
+    /** BS.1770 / EBU R128 loudness in LUFS (-100 for silence) and loudness range in LU.
+        Integrated loudness and range cover everything since the integration was reset.
+    */
+    float momentaryLoudness  = -100.0f;
+    float shortTermLoudness  = -100.0f;
+    float integratedLoudness = -100.0f;
+    float loudnessRange = 0.0f;
+
+    /** How many of the band arrays' entries are in use; the rest are zero. */
+    int numSpectrumBands = maxSpectrumBands;
+
+    /** Smoothed band levels, 0 at the bottom of the engine's dB range to 1 at the top. */
+    std::array<std::array<float, maxSpectrumBands>, numSpectrumViews> spectrumBandLevels {};
+
+    /** Per-bin peak hold and long-term average, reduced to bands on the same scale.
+        spectrumAverageSeconds is how much audio the average covers.
+    */
+    std::array<std::array<float, maxSpectrumBands>, numSpectrumViews> peakBandLevels {};
+    std::array<std::array<float, maxSpectrumBands>, numSpectrumViews> averageBandLevels {};
+    double spectrumAverageSeconds = 0.0;
+
+    //==============================================================================
+    float getRmsLevel (int channel) const noexcept
+    {
+        return juce::isPositiveAndBelow (channel, maxChannels) ? rmsLevels[(size_t) channel] : 0.0f;
+    }
+
+    float getPeakLevel (int channel) const noexcept
+    {
+        return juce::isPositiveAndBelow (channel, maxChannels) ? peakLevels[(size_t) channel] : 0.0f;
+    }
+
+    float getTruePeakLevel (int channel) const noexcept
+    {
+        return juce::isPositiveAndBelow (channel, maxChannels) ? truePeakLevels[(size_t) channel] : 0.0f;
+    }
+
+    float getTruePeakHoldLevel (int channel) const noexcept
+    {
+        return juce::isPositiveAndBelow (channel, maxChannels) ? truePeakHoldLevels[(size_t) channel] : 0.0f;
+    }
+
+    float getCorrelation (int pairIndex = 0) const noexcept
+    {
+        return juce::isPositiveAndBelow (pairIndex, numCorrelationPairs) ? correlations[(size_t) pairIndex] : 0.0f;
+    }
+
+    float getSpectrumBandLevel (int bandIndex, SpectrumView view = SpectrumView::mid) const noexcept
+    {
+        return juce::isPositiveAndBelow (bandIndex, numSpectrumBands)
+                   ? spectrumBandLevels[(size_t) view][(size_t) bandIndex]
+                   : 0.0f;
+    }
+
+    float getPeakBandLevel (int bandIndex, SpectrumView view = SpectrumView::mid) const noexcept
+    {
+        return juce::isPositiveAndBelow (bandIndex, numSpectrumBands)
+                   ? peakBandLevels[(size_t) view][(size_t) bandIndex]
+                   : 0.0f;
+    }
+
+    float getAverageBandLevel (int bandIndex, SpectrumView view = SpectrumView::mid) const noexcept
+    {
+        return juce::isPositiveAndBelow (bandIndex, numSpectrumBands)
+                   ? averageBandLevels[(size_t) view][(size_t) bandIndex]
+                   : 0.0f;
+    }
+};
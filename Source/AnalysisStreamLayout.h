@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+//==============================================================================
+/**
+    The binary layout of the shared-memory analysis stream.
+
+    Plain C++ with no JUCE types, so other programs can include it on its own. A
+    stream is one shared memory object named namePrefix + "<pid>.<instance>":
+    a Header followed by numSlots Slots that frames are written into in turn.
+
+    Each slot is a seqlock. The writer makes the slot's sequence odd, copies the
+    frame in and makes it even again, then bumps Header::framesWritten. A reader
+    copies a slot out between two reads of its sequence and keeps the copy only
+    if both were the same even value; Frame::frameIndex tells it whether the
+    writer has lapped it. Readers never write, so any number of them can follow
+    a stream without the writer knowing.
+
+    Every field is fixed size. Anything that changes their order or meaning must
+    bump `version`; readers refuse versions they don't know.
+*/
+namespace AnalysisStream
+{
+    constexpr std::uint32_t magic = 0x5a414e41; // "ANAZ"
+    constexpr std::uint32_t version = 2; // 2: band count in Frame::numSpectrumBands
+
+    constexpr const char* namePrefix = "/anime-analyzer.";
+
+    constexpr int numSlots = 64;
+    constexpr int maxChannels = 12;
+    constexpr int maxCorrelationPairs = 6;
+    constexpr int maxSpectrumBands = 31;
+    constexpr int numSpectrumViews = 4; // mid, left, right, side
+
+    //==============================================================================
+    /** One AnalysisFrame. Levels are linear, loudness in LUFS / LU, and band
+        levels 0 to 1 over the analyser's dB range. Only the first
+        numSpectrumBands entries of each band array are in use.
+    */
+    struct Frame
+    {
+        std::uint64_t frameIndex;
+        std::int64_t samplePosition;
+        double sampleRate;
+        double spectrumAverageSeconds;
+
+        std::uint32_t numMeteredSamples;
+        std::uint32_t numChannels;
+        std::uint32_t numCorrelationPairs;
+        std::uint32_t numSpectrumBands;
+
+        float rmsLevels[maxChannels];
+        float peakLevels[maxChannels];
+        float truePeakLevels[maxChannels];
+        float truePeakHoldLevels[maxChannels];
+
+        float correlations[maxCorrelationPairs];
+        std::int32_t correlationChannels[maxCorrelationPairs][2];
+
+        float momentaryLoudness;
+        float shortTermLoudness;
+        float integratedLoudness;
+        float loudnessRange;
+
+        float spectrumBandLevels[numSpectrumViews][maxSpectrumBands];
+        float peakBandLevels[numSpectrumViews][maxSpectrumBands];
+        float averageBandLevels[numSpectrumViews][maxSpectrumBands];
+    };
+
+    struct Slot
+    {
+        std::atomic<std::uint32_t> sequence; // odd while the writer is in the slot
+        std::uint32_t reserved;
+        Frame frame;
+    };
+
+    struct Header
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t headerSize;
+        std::uint32_t slotSize;
+        std::uint32_t numSlots;
+        std::uint32_t writerProcessId;
+
+        /** Non-zero once the writer has gone; the data stays readable until unmapped. */
+        std::atomic<std::uint32_t> closed;
+        std::uint32_t reserved;
+
+        /** Frames published so far; the newest is framesWritten - 1, in slot (framesWritten - 1) % numSlots. */
+        std::atomic<std::uint64_t> framesWritten;
+
+        std::uint8_t padding[88];
+    };
+
+    struct Region
+    {
+        Header header;
+        Slot slots[numSlots];
+    };
+
+    // Shared between processes, so the atomics must be plain memory with no hidden lock
+    static_assert (std::atomic<std::uint32_t>::is_always_lock_free && std::atomic<std::uint64_t>::is_always_lock_free,
+                   "The stream's atomics must be lock-free to work across processes");
+    static_assert (sizeof (std::atomic<std::uint32_t>) == 4 && sizeof (std::atomic<std::uint64_t>) == 8, "Unexpected atomic sizes");
+
+    static_assert (sizeof (Header) == 128, "The header layout is part of the format");
+    static_assert (offsetof (Header, framesWritten) == 32, "The header layout is part of the format");
+    static_assert (sizeof (Frame) % 8 == 0 && sizeof (Slot) == sizeof (Frame) + 8, "Slots must pack without padding");
+}
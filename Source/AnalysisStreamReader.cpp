@@ -0,0 +1,192 @@
+#include "AnalysisStreamReader.h"
+#include <cstring>
+
+#if defined (__unix__) || defined (__APPLE__)
+ #define ANIME_ANALYZER_HAS_SHARED_MEMORY 1
+ #include <dirent.h>
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#else
+ #define ANIME_ANALYZER_HAS_SHARED_MEMORY 0
+#endif
+
+AnalysisStreamReader::~AnalysisStreamReader()
+{
+    close();
+}
+
+//==============================================================================
+bool AnalysisStreamReader::open (const std::string& name)
+{
+    close();
+
+   #if ANIME_ANALYZER_HAS_SHARED_MEMORY
+    const auto fd = shm_open (name.c_str(), O_RDONLY, 0);
+
+    if (fd < 0)
+    {
+        lastError = "No stream called " + name;
+        return false;
+    }
+
+    struct stat info;
+    void* memory = MAP_FAILED;
+
+    if (fstat (fd, &info) == 0 && (size_t) info.st_size >= sizeof (AnalysisStream::Region))
+        memory = mmap (nullptr, sizeof (AnalysisStream::Region), PROT_READ, MAP_SHARED, fd, 0);
+
+    ::close (fd);
+
+    if (memory == MAP_FAILED)
+    {
+        lastError = name + " is too small to be an analysis stream";
+        return false;
+    }
+
+    const auto* mapped = static_cast<const AnalysisStream::Region*> (memory);
+    const auto& header = mapped->header;
+
+    // The writer sets the magic last, so a matching magic means the rest is there too
+    const auto headerMagic = header.magic;
+    std::atomic_thread_fence (std::memory_order_acquire);
+
+    if (headerMagic != AnalysisStream::magic)
+        lastError = name + " isn't an analysis stream, or isn't ready yet";
+    else if (header.version != AnalysisStream::version)
+        lastError = name + " has format version " + std::to_string (header.version)
+                      + "; this reader knows version " + std::to_string (AnalysisStream::version);
+    else if (header.headerSize != sizeof (AnalysisStream::Header) || header.slotSize != sizeof (AnalysisStream::Slot)
+               || header.numSlots != (std::uint32_t) AnalysisStream::numSlots)
+        lastError = name + " has an unexpected layout";
+
+    if (! lastError.empty())
+    {
+        munmap (memory, sizeof (AnalysisStream::Region));
+        return false;
+    }
+
+    region = mapped;
+    nextFrameIndex = getNumFramesWritten();
+    numSkippedFrames = 0;
+    return true;
+   #else
+    lastError = "Shared memory streams need POSIX: can't open " + name;
+    return false;
+   #endif
+}
+
+void AnalysisStreamReader::close()
+{
+   #if ANIME_ANALYZER_HAS_SHARED_MEMORY
+    if (region != nullptr)
+        munmap (const_cast<AnalysisStream::Region*> (region), sizeof (AnalysisStream::Region));
+   #endif
+
+    region = nullptr;
+    lastError.clear();
+}
+
+bool AnalysisStreamReader::isWriterClosed() const noexcept
+{
+    return region == nullptr || region->header.closed.load (std::memory_order_acquire) != 0;
+}
+
+std::uint64_t AnalysisStreamReader::getNumFramesWritten() const noexcept
+{
+    return region != nullptr ? region->header.framesWritten.load (std::memory_order_acquire) : 0;
+}
+
+//==============================================================================
+bool AnalysisStreamReader::readNext (AnalysisStream::Frame& frame) noexcept
+{
+    for (;;)
+    {
+        const auto numWritten = getNumFramesWritten();
+
+        // The writer started over under the same name
+        if (numWritten < nextFrameIndex)
+            nextFrameIndex = 0;
+
+        if (nextFrameIndex >= numWritten)
+            return false;
+
+        // The slot after the newest is the one the writer goes into next, so it can't be trusted
+        const auto oldestReadable = numWritten > (std::uint64_t) AnalysisStream::numSlots - 1
+                                        ? numWritten - ((std::uint64_t) AnalysisStream::numSlots - 1)
+                                        : 0;
+
+        if (nextFrameIndex < oldestReadable)
+        {
+            numSkippedFrames += oldestReadable - nextFrameIndex;
+            nextFrameIndex = oldestReadable;
+        }
+
+        if (readSlot (nextFrameIndex, frame))
+        {
+            ++nextFrameIndex;
+            return true;
+        }
+
+        // Lapped while copying: catch up and try again
+    }
+}
+
+bool AnalysisStreamReader::readLatest (AnalysisStream::Frame& frame) const noexcept
+{
+    for (int attempt = 0; attempt < 4; ++attempt)
+    {
+        const auto numWritten = getNumFramesWritten();
+
+        if (numWritten == 0)
+            return false;
+
+        if (readSlot (numWritten - 1, frame))
+            return true;
+    }
+
+    return false;
+}
+
+bool AnalysisStreamReader::readSlot (std::uint64_t frameIndex, AnalysisStream::Frame& frame) const noexcept
+{
+    const auto& slot = region->slots[frameIndex % (std::uint64_t) AnalysisStream::numSlots];
+
+    for (int attempt = 0; attempt < 4; ++attempt)
+    {
+        const auto before = slot.sequence.load (std::memory_order_acquire);
+
+        if ((before & 1) != 0)
+            continue;
+
+        std::memcpy (&frame, &slot.frame, sizeof (frame));
+        std::atomic_thread_fence (std::memory_order_acquire);
+
+        // Unchanged and even: the writer didn't touch the slot while we copied it
+        if (slot.sequence.load (std::memory_order_relaxed) == before)
+            return frame.frameIndex == frameIndex;
+    }
+
+    return false;
+}
+
+std::vector<std::string> AnalysisStreamReader::findStreams()
+{
+    std::vector<std::string> names;
+
+   #if defined (__linux__)
+    const std::string prefix (AnalysisStream::namePrefix + 1); // without the leading '/'
+
+    if (auto* directory = opendir ("/dev/shm"))
+    {
+        while (const auto* entry = readdir (directory))
+            if (std::strncmp (entry->d_name, prefix.c_str(), prefix.size()) == 0)
+                names.push_back ("/" + std::string (entry->d_name));
+
+        closedir (directory);
+    }
+   #endif
+
+    return names;
+}
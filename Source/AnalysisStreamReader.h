@@ -0,0 +1,63 @@
+#pragma once
+
+#include "AnalysisStreamLayout.h"
+#include <string>
+#include <vector>
+
+//==============================================================================
+/**
+    Follows an analysis stream published by AnalysisStreamWriter.
+
+    Only needs the standard library and POSIX, so visualisers can link it
+    without JUCE. It maps the stream read-only and never writes to it, so any
+    number of readers can follow one stream, each at its own pace. A reader
+    that falls more than the ring's length behind skips ahead to the oldest
+    frame still there and counts what it missed.
+*/
+class AnalysisStreamReader
+{
+public:
+    AnalysisStreamReader() = default;
+    ~AnalysisStreamReader();
+
+    AnalysisStreamReader (const AnalysisStreamReader&) = delete;
+    AnalysisStreamReader& operator= (const AnalysisStreamReader&) = delete;
+
+    //==============================================================================
+    /** Maps a stream and checks its header. Reading starts at the next frame
+        published; on failure getLastError() says why.
+    */
+    bool open (const std::string& name);
+    void close();
+
+    bool isOpen() const noexcept                    { return region != nullptr; }
+    const std::string& getLastError() const noexcept { return lastError; }
+
+    /** True once the writer has closed the stream; what's in it can still be read. */
+    bool isWriterClosed() const noexcept;
+
+    std::uint64_t getNumFramesWritten() const noexcept;
+    std::uint64_t getNumSkippedFrames() const noexcept  { return numSkippedFrames; }
+
+    //==============================================================================
+    /** The next frame after the last one this reader returned. False if there
+        isn't one yet.
+    */
+    bool readNext (AnalysisStream::Frame& frame) noexcept;
+
+    /** The newest frame, without affecting readNext(). False if there isn't one. */
+    bool readLatest (AnalysisStream::Frame& frame) const noexcept;
+
+    /** Streams currently published on this machine. Needs a listable shared
+        memory directory (Linux); elsewhere it's empty and names must be known.
+    */
+    static std::vector<std::string> findStreams();
+
+private:
+    const AnalysisStream::Region* region = nullptr;
+    std::uint64_t nextFrameIndex = 0;
+    std::uint64_t numSkippedFrames = 0;
+    std::string lastError;
+
+    bool readSlot (std::uint64_t frameIndex, AnalysisStream::Frame& frame) const noexcept;
+};
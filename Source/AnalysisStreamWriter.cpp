@@ -0,0 +1,155 @@
+#include "AnalysisStreamWriter.h"
+#include <algorithm>
+
+#if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+ #define ANIME_ANALYZER_HAS_SHARED_MEMORY 1
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <unistd.h>
+#else
+ #define ANIME_ANALYZER_HAS_SHARED_MEMORY 0
+#endif
+
+AnalysisStreamWriter::~AnalysisStreamWriter()
+{
+    close();
+}
+
+bool AnalysisStreamWriter::open (const juce::String& name)
+{
+    close();
+
+   #if ANIME_ANALYZER_HAS_SHARED_MEMORY
+    const auto fd = shm_open (name.toRawUTF8(), O_CREAT | O_RDWR, 0644);
+
+    if (fd < 0)
+        return false;
+
+    void* memory = MAP_FAILED;
+
+    if (ftruncate (fd, (off_t) sizeof (AnalysisStream::Region)) == 0)
+        memory = mmap (nullptr, sizeof (AnalysisStream::Region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    ::close (fd);
+
+    if (memory == MAP_FAILED)
+    {
+        shm_unlink (name.toRawUTF8());
+        return false;
+    }
+
+    region = static_cast<AnalysisStream::Region*> (memory);
+    streamName = name;
+
+    // The name may be left over from a process that died with it open, so the
+    // magic goes last: a reader that finds it sees a complete header
+    auto& header = region->header;
+    header.magic = 0;
+    std::atomic_thread_fence (std::memory_order_release);
+
+    header.version = AnalysisStream::version;
+    header.headerSize = (std::uint32_t) sizeof (AnalysisStream::Header);
+    header.slotSize = (std::uint32_t) sizeof (AnalysisStream::Slot);
+    header.numSlots = (std::uint32_t) AnalysisStream::numSlots;
+    header.writerProcessId = (std::uint32_t) getpid();
+    header.closed.store (0, std::memory_order_relaxed);
+    header.framesWritten.store (0, std::memory_order_relaxed);
+
+    for (auto& slot : region->slots)
+        slot.sequence.store (0, std::memory_order_relaxed);
+
+    std::atomic_thread_fence (std::memory_order_release);
+    header.magic = AnalysisStream::magic;
+    return true;
+   #else
+    juce::ignoreUnused (name);
+    return false;
+   #endif
+}
+
+void AnalysisStreamWriter::close()
+{
+   #if ANIME_ANALYZER_HAS_SHARED_MEMORY
+    if (region == nullptr)
+        return;
+
+    region->header.closed.store (1, std::memory_order_release);
+
+    munmap (region, sizeof (AnalysisStream::Region));
+    shm_unlink (streamName.toRawUTF8());
+   #endif
+
+    region = nullptr;
+    streamName.clear();
+}
+
+void AnalysisStreamWriter::write (const AnalysisFrame& frame, double sampleRate) noexcept
+{
+    if (region == nullptr)
+        return;
+
+    auto& header = region->header;
+    const auto index = header.framesWritten.load (std::memory_order_relaxed);
+    auto& slot = region->slots[index % (std::uint64_t) AnalysisStream::numSlots];
+
+    // Odd while we're in the slot, so a reader that overlaps us throws its copy away
+    const auto sequence = slot.sequence.load (std::memory_order_relaxed);
+    slot.sequence.store (sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    auto& out = slot.frame;
+    out.frameIndex = index;
+    out.samplePosition = frame.samplePosition;
+    out.sampleRate = sampleRate;
+    out.spectrumAverageSeconds = frame.spectrumAverageSeconds;
+    out.numMeteredSamples = (std::uint32_t) frame.numMeteredSamples;
+    out.numChannels = (std::uint32_t) frame.numChannels;
+    out.numCorrelationPairs = (std::uint32_t) frame.numCorrelationPairs;
+    out.numSpectrumBands = (std::uint32_t) frame.numSpectrumBands;
+
+    static_assert (AnalysisStream::maxChannels == AnalysisFrame::maxChannels
+                    && AnalysisStream::maxCorrelationPairs == AnalysisFrame::maxCorrelationPairs
+                    && AnalysisStream::maxSpectrumBands == AnalysisFrame::maxSpectrumBands
+                    && AnalysisStream::numSpectrumViews == AnalysisFrame::numSpectrumViews,
+                   "The stream format must hold a whole frame");
+
+    std::copy (frame.rmsLevels.begin(), frame.rmsLevels.end(), out.rmsLevels);
+    std::copy (frame.peakLevels.begin(), frame.peakLevels.end(), out.peakLevels);
+    std::copy (frame.truePeakLevels.begin(), frame.truePeakLevels.end(), out.truePeakLevels);
+    std::copy (frame.truePeakHoldLevels.begin(), frame.truePeakHoldLevels.end(), out.truePeakHoldLevels);
+    std::copy (frame.correlations.begin(), frame.correlations.end(), out.correlations);
+
+    for (size_t pair = 0; pair < (size_t) AnalysisStream::maxCorrelationPairs; ++pair)
+    {
+        out.correlationChannels[pair][0] = frame.correlationChannels[pair][0];
+        out.correlationChannels[pair][1] = frame.correlationChannels[pair][1];
+    }
+
+    out.momentaryLoudness = frame.momentaryLoudness;
+    out.shortTermLoudness = frame.shortTermLoudness;
+    out.integratedLoudness = frame.integratedLoudness;
+    out.loudnessRange = frame.loudnessRange;
+
+    for (size_t view = 0; view < (size_t) AnalysisStream::numSpectrumViews; ++view)
+    {
+        std::copy (frame.spectrumBandLevels[view].begin(), frame.spectrumBandLevels[view].end(), out.spectrumBandLevels[view]);
+        std::copy (frame.peakBandLevels[view].begin(), frame.peakBandLevels[view].end(), out.peakBandLevels[view]);
+        std::copy (frame.averageBandLevels[view].begin(), frame.averageBandLevels[view].end(), out.averageBandLevels[view]);
+    }
+
+    slot.sequence.store (sequence + 2, std::memory_order_release);
+    header.framesWritten.store (index + 1, std::memory_order_release);
+}
+
+juce::String AnalysisStreamWriter::createUniqueName()
+{
+    static std::atomic<int> nextInstance { 0 };
+
+   #if ANIME_ANALYZER_HAS_SHARED_MEMORY
+    const auto processId = (int) getpid();
+   #else
+    const auto processId = 0;
+   #endif
+
+    return AnalysisStream::namePrefix + juce::String (processId) + "." + juce::String (nextInstance++);
+}
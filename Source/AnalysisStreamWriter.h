@@ -0,0 +1,43 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "AnalysisFrame.h"
+#include "AnalysisStreamLayout.h"
+
+//==============================================================================
+/**
+    Publishes analysis frames into a named shared memory ring (see
+    AnalysisStreamLayout.h) for visualisers in other processes.
+
+    open() and close() make system calls, so call them off the audio thread.
+    write() is a copy into the mapped memory and is safe wherever frames are
+    published; it does nothing while the stream isn't open. Shared memory needs
+    POSIX (shm_open), so on other platforms open() fails and the writer stays idle.
+*/
+class AnalysisStreamWriter
+{
+public:
+    AnalysisStreamWriter() = default;
+    ~AnalysisStreamWriter();
+
+    /** Creates (or takes over) the shared memory object; name starts with a '/'. */
+    bool open (const juce::String& name);
+
+    /** Marks the stream closed for its readers and removes its name. */
+    void close();
+
+    bool isOpen() const noexcept                    { return region != nullptr; }
+    const juce::String& getName() const noexcept    { return streamName; }
+
+    /** Publishes a frame. One writer thread at a time. */
+    void write (const AnalysisFrame& frame, double sampleRate) noexcept;
+
+    /** A name no other instance in this process uses, tagged with the process id. */
+    static juce::String createUniqueName();
+
+private:
+    AnalysisStream::Region* region = nullptr;
+    juce::String streamName;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisStreamWriter)
+};
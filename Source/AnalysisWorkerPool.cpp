@@ -0,0 +1,169 @@
+#include "AnalysisWorkerPool.h"
+#include <algorithm>
+#include <cmath>
+
+AnalysisWorkerPool::AnalysisWorkerPool()
+{
+    // Leave a core for the host's own audio thread
+    const auto numWorkers = juce::jmax (1, juce::SystemStats::getNumPhysicalCpus() - 1);
+
+    for (int i = 0; i < numWorkers; ++i)
+        workers.push_back (std::make_unique<Worker> (*this, i));
+
+    for (auto& worker : workers)
+        worker->startThread (juce::Thread::Priority::low);
+}
+
+AnalysisWorkerPool::~AnalysisWorkerPool()
+{
+    for (auto& worker : workers)
+        worker->signalThreadShouldExit();
+
+    for (auto& worker : workers)
+        worker->stopThread (1000);
+}
+
+void AnalysisWorkerPool::addClient (Client& client)
+{
+    auto slot = std::make_unique<ClientSlot>();
+    slot->client = &client;
+
+    const juce::ScopedWriteLock sl (clientsLock);
+    clients.push_back (std::move (slot));
+}
+
+void AnalysisWorkerPool::removeClient (Client& client)
+{
+    const juce::ScopedWriteLock sl (clientsLock);
+
+    clients.erase (std::remove_if (clients.begin(), clients.end(),
+                                   [&client] (const auto& slot) { return slot->client == &client; }),
+                   clients.end());
+}
+
+int AnalysisWorkerPool::getNumClients() const
+{
+    const juce::ScopedReadLock sl (clientsLock);
+    return (int) clients.size();
+}
+
+//==============================================================================
+void AnalysisWorkerPool::Worker::run()
+{
+    while (! threadShouldExit())
+    {
+        const auto now = juce::Time::getMillisecondCounterHiRes();
+        const auto round = getRound (now);
+
+        if (round != lastRound && round % (juce::uint64) owner.getFrameRateDivider() == 0)
+        {
+            lastRound = round;
+            owner.runRound (index, round);
+            owner.reportRound (round, juce::Time::getMillisecondCounterHiRes());
+            owner.runBackgroundWork (index);
+            continue;
+        }
+
+        wait (juce::jmax (1, (int) std::ceil ((double) (round + 1) * roundIntervalMs - now)));
+    }
+}
+
+void AnalysisWorkerPool::runRound (int workerIndex, juce::uint64 round) noexcept
+{
+    const juce::ScopedReadLock sl (clientsLock);
+
+    const auto numClients = (int) clients.size();
+    const auto numWorkers = (int) workers.size();
+    const auto divider = getFrameRateDivider();
+
+    // Our own share front to back...
+    for (int i = workerIndex; i < numClients; i += numWorkers)
+        runClient (*clients[(size_t) i], round, divider);
+
+    // ...then whatever the others haven't got to yet, from the back of their shares
+    for (int offset = 1; offset < numWorkers; ++offset)
+    {
+        const auto victim = (workerIndex + offset) % numWorkers;
+
+        if (victim >= numClients)
+            continue;
+
+        const auto last = victim + (numClients - 1 - victim) / numWorkers * numWorkers;
+
+        for (int i = last; i >= victim; i -= numWorkers)
+            runClient (*clients[(size_t) i], round, divider);
+    }
+}
+
+bool AnalysisWorkerPool::runClient (ClientSlot& slot, juce::uint64 round, int divider) noexcept
+{
+    // Claim it for this round unless someone already has; a worker still in an
+    // older round mustn't take it back
+    auto claimed = slot.claimedRound.load (std::memory_order_relaxed);
+
+    do
+    {
+        if (claimed >= round)
+            return false;
+    }
+    while (! slot.claimedRound.compare_exchange_weak (claimed, round, std::memory_order_acq_rel));
+
+    // Still running from a round that overran; this round's samples wait for the next
+    if (slot.running.exchange (true, std::memory_order_acquire))
+        return false;
+
+    slot.client->runAnalysis (divider);
+    slot.running.store (false, std::memory_order_release);
+    return true;
+}
+
+void AnalysisWorkerPool::runBackgroundWork (int workerIndex)
+{
+    const juce::ScopedReadLock sl (clientsLock);
+
+    const auto numClients = (int) clients.size();
+    const auto numWorkers = (int) workers.size();
+
+    for (int i = workerIndex; i < numClients; i += numWorkers)
+    {
+        auto& slot = *clients[(size_t) i];
+
+        if (! slot.client->needsBackgroundWork())
+            continue;
+
+        // Shares move as clients come and go, so another worker may have it already
+        if (slot.runningBackgroundWork.exchange (true, std::memory_order_acquire))
+            continue;
+
+        slot.client->runBackgroundWork();
+        slot.runningBackgroundWork.store (false, std::memory_order_release);
+    }
+}
+
+void AnalysisWorkerPool::reportRound (juce::uint64 round, double finishedMs) noexcept
+{
+    auto divider = getFrameRateDivider();
+    const auto roundMs = (double) (roundIntervalMs * divider);
+    const auto elapsedMs = finishedMs - (double) round * roundIntervalMs;
+
+    if (elapsedMs >= roundMs)
+    {
+        calmRounds.store (0, std::memory_order_relaxed);
+
+        if (divider < maxFrameRateDivider)
+            frameRateDivider.compare_exchange_strong (divider, divider * 2);
+
+        return;
+    }
+
+    // A round's work stays about the same whatever the divider, since a longer round
+    // computes proportionally fewer frames; halving it would halve the time it has
+    if (divider > 1 && elapsedMs < calmRoundShare * 0.5 * roundMs)
+    {
+        if (calmRounds.fetch_add (1, std::memory_order_relaxed) + 1 >= calmRoundsBeforeSpeedUp * getNumWorkers())
+        {
+            calmRounds.store (0, std::memory_order_relaxed);
+            frameRateDivider.compare_exchange_strong (divider, divider / 2);
+        }
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+    One set of analysis threads for every plugin instance in the process, so a
+    session with a hundred instances runs a handful of workers rather than a
+    hundred threads of its own. Share it with juce::SharedResourcePointer; it
+    is created with the first instance and goes with the last.
+
+    Work is done in rounds, one every roundIntervalMs. In each round every
+    client runs once, on whichever worker claims it first. Each worker starts
+    on its own share of the clients, front to back, then steals what's left of
+    the others' shares from the back, so a worker stuck on a heavy client
+    doesn't hold up the rest. Clients hand their samples over through their
+    own lock-free queues, so claiming a client is all the coordination needed.
+
+    If a round is still running when the next one should start, the pool
+    doubles its frame rate divider (up to maxFrameRateDivider): rounds come
+    that many times less often, and clients are asked to compute only one
+    frame in that many. Once rounds finish with room to spare for a while, it
+    halves the divider again. The whole process's analysis load therefore
+    levels off at what the workers can do, with the displays refreshing
+    less often, instead of the queues backing up.
+
+    After each round, every worker also runs the background work of the clients
+    in its share that ask for it (rebuilding tables for new settings, say). That
+    is kept out of the round's timing, and a client that asks for nothing costs
+    one check of a flag.
+*/
+class AnalysisWorkerPool
+{
+public:
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+
+        /** Worker thread: drains whatever the client has queued, computing one
+            frame in frameRateDivider. Never runs on two workers at once.
+        */
+        virtual void runAnalysis (int frameRateDivider) noexcept = 0;
+
+        /** Checked by a worker after every round, so it should be no more than an atomic load. */
+        virtual bool needsBackgroundWork() const noexcept   { return false; }
+
+        /** Worker thread, between rounds, when needsBackgroundWork() returned true. May
+            run alongside runAnalysis(), but never on two workers at once.
+        */
+        virtual void runBackgroundWork() {}
+    };
+
+    static constexpr int roundIntervalMs = 5;
+    static constexpr int maxFrameRateDivider = 8;
+
+    AnalysisWorkerPool();
+    ~AnalysisWorkerPool();
+
+    /** Not realtime safe; may wait for the round in progress. */
+    void addClient (Client&);
+
+    /** Waits for the round in progress, so the client is never called once this returns. */
+    void removeClient (Client&);
+
+    int getNumWorkers() const noexcept                  { return (int) workers.size(); }
+    int getNumClients() const;
+    int getFrameRateDivider() const noexcept            { return frameRateDivider.load (std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker (AnalysisWorkerPool& p, int workerIndex)
+            : juce::Thread ("ANIME-ANALYZER analysis " + juce::String (workerIndex)), owner (p), index (workerIndex) {}
+
+        void run() override;
+
+    private:
+        AnalysisWorkerPool& owner;
+        const int index;
+        juce::uint64 lastRound = 0;
+    };
+
+    struct ClientSlot
+    {
+        Client* client = nullptr;
+        std::atomic<juce::uint64> claimedRound { 0 };
+        std::atomic<bool> running { false };
+        std::atomic<bool> runningBackgroundWork { false };
+    };
+
+    // Rounds that finish within this share of their time count towards speeding up again
+    static constexpr double calmRoundShare = 0.5;
+    static constexpr int calmRoundsBeforeSpeedUp = 40;
+
+    static juce::uint64 getRound (double milliseconds) noexcept     { return (juce::uint64) (milliseconds / roundIntervalMs); }
+
+    void runRound (int workerIndex, juce::uint64 round) noexcept;
+    bool runClient (ClientSlot&, juce::uint64 round, int divider) noexcept;
+    void runBackgroundWork (int workerIndex);
+    void reportRound (juce::uint64 round, double finishedMs) noexcept;
+
+    // Workers hold it for reading during a round; adding or removing a client writes
+    juce::ReadWriteLock clientsLock;
+    std::vector<std::unique_ptr<ClientSlot>> clients;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::atomic<int> frameRateDivider { 1 };
+    std::atomic<int> calmRounds { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisWorkerPool)
+};
@@ -0,0 +1,129 @@
+#include "ChannelLayoutInfo.h"
+
+namespace ChannelLayoutInfo
+{
+namespace
+{
+    using ChannelType = juce::AudioChannelSet::ChannelType;
+
+    constexpr float minus3dB = 0.70710678f;
+
+    struct TypePair
+    {
+        ChannelType left, right;
+    };
+
+    // Front first, so the main pair is always pair 0
+    constexpr TypePair mirroredTypes[] =
+    {
+        { juce::AudioChannelSet::left,             juce::AudioChannelSet::right },
+        { juce::AudioChannelSet::leftSurround,     juce::AudioChannelSet::rightSurround },
+        { juce::AudioChannelSet::leftSurroundSide, juce::AudioChannelSet::rightSurroundSide },
+        { juce::AudioChannelSet::leftSurroundRear, juce::AudioChannelSet::rightSurroundRear },
+        { juce::AudioChannelSet::topFrontLeft,     juce::AudioChannelSet::topFrontRight },
+        { juce::AudioChannelSet::topRearLeft,      juce::AudioChannelSet::topRearRight },
+        { juce::AudioChannelSet::topSideLeft,      juce::AudioChannelSet::topSideRight },
+        { juce::AudioChannelSet::wideLeft,         juce::AudioChannelSet::wideRight },
+        { juce::AudioChannelSet::leftCentre,       juce::AudioChannelSet::rightCentre }
+    };
+
+    bool isLFE (ChannelType type) noexcept
+    {
+        return type == juce::AudioChannelSet::LFE || type == juce::AudioChannelSet::LFE2;
+    }
+}
+
+//==============================================================================
+DownmixMatrix getDefaultDownmix (const juce::AudioChannelSet& layout)
+{
+    DownmixMatrix matrix;
+    const auto numChannels = juce::jmin (layout.size(), DownmixMatrix::maxChannels);
+
+    if (numChannels == 1)
+    {
+        matrix.gains[0][0] = matrix.gains[1][0] = 1.0f;
+        return matrix;
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto type = layout.getTypeOfChannel (ch);
+
+        if (isLFE (type))
+            continue;
+
+        // No positions to go by: the first two are the front pair, the rest alternate sides
+        if (type >= juce::AudioChannelSet::discreteChannel0)
+        {
+            matrix.gains[(size_t) (ch % 2)][(size_t) ch] = ch < 2 ? 1.0f : minus3dB;
+            continue;
+        }
+
+        if (type == juce::AudioChannelSet::left || type == juce::AudioChannelSet::right)
+        {
+            matrix.gains[type == juce::AudioChannelSet::left ? 0 : 1][(size_t) ch] = 1.0f;
+            continue;
+        }
+
+        int side = -1;
+
+        for (const auto& pair : mirroredTypes)
+        {
+            if (type == pair.left)  side = 0;
+            if (type == pair.right) side = 1;
+        }
+
+        if (side >= 0)
+        {
+            matrix.gains[(size_t) side][(size_t) ch] = minus3dB;
+        }
+        else
+        {
+            // Centre and other middle channels go to both sides
+            matrix.gains[0][(size_t) ch] = matrix.gains[1][(size_t) ch] = minus3dB;
+        }
+    }
+
+    return matrix;
+}
+
+float getLoudnessWeight (juce::AudioChannelSet::ChannelType type) noexcept
+{
+    if (isLFE (type))
+        return 0.0f;
+
+    switch (type)
+    {
+        case juce::AudioChannelSet::leftSurround:
+        case juce::AudioChannelSet::rightSurround:
+        case juce::AudioChannelSet::leftSurroundSide:
+        case juce::AudioChannelSet::rightSurroundSide:
+        case juce::AudioChannelSet::wideLeft:
+        case juce::AudioChannelSet::wideRight:
+            return 1.41f;
+
+        default:
+            return 1.0f;
+    }
+}
+
+std::vector<ChannelPair> getCorrelationPairs (const juce::AudioChannelSet& layout, int maxPairs)
+{
+    std::vector<ChannelPair> pairs;
+
+    for (const auto& types : mirroredTypes)
+    {
+        const auto first  = layout.getChannelIndexForType (types.left);
+        const auto second = layout.getChannelIndexForType (types.right);
+
+        if (first >= 0 && second >= 0 && (int) pairs.size() < maxPairs)
+            pairs.push_back ({ first, second });
+    }
+
+    if (pairs.empty() && layout.isDiscreteLayout())
+        for (int ch = 0; ch + 1 < layout.size() && (int) pairs.size() < maxPairs; ch += 2)
+            pairs.push_back ({ ch, ch + 1 });
+
+    return pairs;
+}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <vector>
+
+//==============================================================================
+/**
+    How the spectrum's stereo pair is made from the input channels:
+    left = sum of gains[0][ch] * input[ch], right likewise with gains[1].
+*/
+struct DownmixMatrix
+{
+    static constexpr int maxChannels = 12; // 7.1.4
+
+    std::array<std::array<float, maxChannels>, 2> gains {};
+
+    bool operator== (const DownmixMatrix& other) const noexcept     { return gains == other.gains; }
+    bool operator!= (const DownmixMatrix& other) const noexcept     { return gains != other.gains; }
+};
+
+//==============================================================================
+/**
+    What the analyser needs to know about a channel layout: the default
+    downmix, the BS.1770 loudness weight of each channel and which channels
+    are compared for correlation.
+*/
+namespace ChannelLayoutInfo
+{
+    struct ChannelPair
+    {
+        int first, second;
+    };
+
+    /** ITU-R BS.775 style: fronts at full level, centre and surrounds at -3 dB
+        into their side, LFE left out. A single channel goes to both sides.
+    */
+    DownmixMatrix getDefaultDownmix (const juce::AudioChannelSet& layout);
+
+    /** BS.1770-4: 1.41 for the side channels (60 to 120 degrees, below 30 degrees
+        elevation), 0 for LFE, 1 for everything else.
+    */
+    float getLoudnessWeight (juce::AudioChannelSet::ChannelType type) noexcept;
+
+    /** The mirrored left/right pairs in the layout (front, surrounds, heights...),
+        front first. Discrete layouts are paired up in order.
+    */
+    std::vector<ChannelPair> getCorrelationPairs (const juce::AudioChannelSet& layout, int maxPairs);
+}
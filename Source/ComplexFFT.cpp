@@ -0,0 +1,94 @@
+#include "ComplexFFT.h"
+
+#if ANIME_ANALYZER_HAS_PFFFT // set by CMake when the PFFFT backend is built
+ #include <pffft.h>
+#endif
+
+ComplexFFT::Backend ComplexFFT::getDefaultBackend() noexcept
+{
+   #if ANIME_ANALYZER_HAS_PFFFT
+    return Backend::pffft;
+   #else
+    return Backend::juce;
+   #endif
+}
+
+bool ComplexFFT::isAvailable (Backend b) noexcept
+{
+   #if ANIME_ANALYZER_HAS_PFFFT
+    juce::ignoreUnused (b);
+    return true;
+   #else
+    return b == Backend::juce;
+   #endif
+}
+
+const char* ComplexFFT::getBackendName (Backend b) noexcept
+{
+    switch (b)
+    {
+        case Backend::pffft:    return "pffft";
+        case Backend::juce:     break;
+    }
+
+    return "juce";
+}
+
+//==============================================================================
+ComplexFFT::ComplexFFT (int order, Backend requestedBackend)
+    : size (1 << order)
+{
+    input.allocate ((size_t) size);
+    output.allocate ((size_t) size);
+
+   #if ANIME_ANALYZER_HAS_PFFFT
+    // PFFFT's complex transforms need a multiple of 16 points; it returns null otherwise
+    if (requestedBackend == Backend::pffft)
+    {
+        pffftSetup = pffft_new_setup (size, PFFFT_COMPLEX);
+
+        if (pffftSetup != nullptr)
+        {
+            // Without a work buffer it would take one from the stack, or the heap for big sizes
+            work.allocate ((size_t) size);
+            backend = Backend::pffft;
+            return;
+        }
+    }
+   #else
+    juce::ignoreUnused (requestedBackend);
+   #endif
+
+    juceFFT = std::make_unique<juce::dsp::FFT> (order);
+}
+
+ComplexFFT::~ComplexFFT()
+{
+   #if ANIME_ANALYZER_HAS_PFFFT
+    if (pffftSetup != nullptr)
+        pffft_destroy_setup (pffftSetup);
+   #endif
+}
+
+void ComplexFFT::AlignedBuffer::allocate (size_t numPoints)
+{
+    storage.calloc (numPoints * sizeof (Complex) + alignment);
+
+    const auto address = reinterpret_cast<std::uintptr_t> (storage.get());
+    data = reinterpret_cast<Complex*> ((address + alignment - 1) & ~(std::uintptr_t) (alignment - 1));
+}
+
+void ComplexFFT::perform() noexcept
+{
+   #if ANIME_ANALYZER_HAS_PFFFT
+    // Ordered output is interleaved re/im in natural order, the layout of std::complex
+    if (pffftSetup != nullptr)
+    {
+        pffft_transform_ordered (pffftSetup, reinterpret_cast<const float*> (input.data),
+                                 reinterpret_cast<float*> (output.data), reinterpret_cast<float*> (work.data), PFFFT_FORWARD);
+        return;
+    }
+   #endif
+
+    juceFFT->perform (input.data, output.data, false);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <memory>
+
+struct PFFFT_Setup;
+
+//==============================================================================
+/**
+    The forward complex FFT behind the spectrum, on one of two backends:
+     - juce: juce::dsp::FFT, which is vDSP on Apple platforms and IPP where
+       JUCE was built with it, but a plain scalar radix-4 everywhere else
+     - pffft: PFFFT, an SSE/NEON FFT, built in when CMake is configured with
+       ANIME_ANALYZER_FFT_BACKEND=pffft (which also makes it the default)
+
+    Both give the same unscaled transform in natural order, so the backend only
+    changes how fast it runs. The input and output are owned by the FFT and
+    aligned for the widest SIMD loads; fill the input, call perform() and read
+    the output.
+*/
+class ComplexFFT
+{
+public:
+    using Complex = juce::dsp::Complex<float>;
+
+    enum class Backend
+    {
+        juce,
+        pffft
+    };
+
+    /** The backend the build selected. */
+    static Backend getDefaultBackend() noexcept;
+    static bool isAvailable (Backend) noexcept;
+    static const char* getBackendName (Backend) noexcept;
+
+    /** Not realtime safe. A backend that isn't built in, or can't do this size, falls back to juce. */
+    explicit ComplexFFT (int order, Backend = getDefaultBackend());
+    ~ComplexFFT();
+
+    int getSize() const noexcept                    { return size; }
+    Backend getBackend() const noexcept             { return backend; }
+
+    Complex* getInput() noexcept                    { return input.data; }
+    const Complex* getOutput() const noexcept       { return output.data; }
+
+    /** Transforms the input into the output; the input is left as it was. */
+    void perform() noexcept;
+
+private:
+    // A cache line, which covers AVX-512 loads as well
+    static constexpr size_t alignment = 64;
+
+    struct AlignedBuffer
+    {
+        void allocate (size_t numPoints);
+
+        juce::HeapBlock<char> storage;
+        Complex* data = nullptr;
+    };
+
+    const int size;
+    Backend backend = Backend::juce;
+
+    AlignedBuffer input, output, work;
+
+    std::unique_ptr<juce::dsp::FFT> juceFFT;
+    PFFFT_Setup* pffftSetup = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ComplexFFT)
+};
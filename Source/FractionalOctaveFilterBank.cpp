@@ -0,0 +1,251 @@
+#include "FractionalOctaveFilterBank.h"
+#include <cmath>
+#include <complex>
+
+void FractionalOctaveFilterBank::prepare (double sampleRate, const std::vector<double>& bandEdges)
+{
+    constexpr int lanes = (int) Vec::size();
+    const auto zero = Vec::expand (0.0f);
+
+    numBands = juce::jmax (0, (int) bandEdges.size() - 1);
+
+    std::vector<int> bandStages ((size_t) numBands);
+    int numStages = 1;
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        bandStages[(size_t) band] = getStageForBand (bandEdges[(size_t) band + 1], sampleRate);
+        numStages = juce::jmax (numStages, bandStages[(size_t) band] + 1);
+    }
+
+    stages.clear();
+    stages.resize ((size_t) numStages);
+
+    for (int i = 0; i < numStages; ++i)
+    {
+        auto& stage = stages[(size_t) i];
+        stage.sampleRate = sampleRate / (double) (1 << i);
+        stage.decimatedLeft.assign ((size_t) maxChunkSize / 2 + 1, 0.0f);
+        stage.decimatedRight.assign ((size_t) maxChunkSize / 2 + 1, 0.0f);
+
+        // A stage's bands are neighbours, so they fill its groups in order
+        for (int band = 0; band < numBands; ++band)
+        {
+            if (bandStages[(size_t) band] != i)
+                continue;
+
+            if (stage.groups.empty() || stage.groups.back().numBands == lanes)
+            {
+                BandGroup group;
+                group.firstBand = band;
+                group.gains.fill (zero);
+                group.a1.fill (zero);
+                group.a2.fill (zero);
+                stage.groups.push_back (group);
+            }
+
+            auto& group = stage.groups.back();
+            const auto lane = (size_t) group.numBands++;
+
+            std::array<double, numSections> gains, a1, a2;
+            designBand (bandEdges[(size_t) band], bandEdges[(size_t) band + 1], stage.sampleRate, gains, a1, a2);
+
+            for (size_t k = 0; k < (size_t) numSections; ++k)
+            {
+                group.gains[k].set (lane, (float) gains[k]);
+                group.a1[k].set (lane, (float) a1[k]);
+                group.a2[k].set (lane, (float) a2[k]);
+            }
+        }
+    }
+
+    setIntegrationTime (integrationTime);
+    reset();
+}
+
+void FractionalOctaveFilterBank::reset() noexcept
+{
+    const auto zero = Vec::expand (0.0f);
+
+    for (auto& stage : stages)
+    {
+        stage.decimatorLeft.reset();
+        stage.decimatorRight.reset();
+
+        for (auto& group : stage.groups)
+        {
+            for (auto* state : { &group.leftState1, &group.leftState2, &group.rightState1, &group.rightState2 })
+                state->fill (zero);
+
+            group.power.fill (zero);
+        }
+    }
+}
+
+void FractionalOctaveFilterBank::setIntegrationTime (double seconds) noexcept
+{
+    integrationTime = juce::jmax (0.001, seconds);
+
+    for (auto& stage : stages)
+        stage.integratorCoefficient = Vec::expand ((float) (1.0 - std::exp (-1.0 / (integrationTime * stage.sampleRate))));
+}
+
+//==============================================================================
+void FractionalOctaveFilterBank::process (const float* left, const float* right, int numSamples) noexcept
+{
+    jassert (numSamples <= maxChunkSize);
+
+    if (stages.empty() || numSamples <= 0)
+        return;
+
+    // A band that has gone quiet decays into denormals otherwise
+    const juce::ScopedNoDenormals noDenormals;
+    processStage (0, left, right, numSamples);
+}
+
+void FractionalOctaveFilterBank::processStage (int stageIndex, const float* left, const float* right, int numSamples) noexcept
+{
+    auto& stage = stages[(size_t) stageIndex];
+    const bool hasNextStage = stageIndex + 1 < (int) stages.size();
+
+    int numDecimated = 0;
+
+    if (hasNextStage)
+    {
+        numDecimated = stage.decimatorLeft.process (left, numSamples, stage.decimatedLeft.data());
+        stage.decimatorRight.process (right, numSamples, stage.decimatedRight.data());
+    }
+
+    const auto zero = Vec::expand (0.0f);
+    const auto half = Vec::expand (0.5f);
+    const auto alpha = stage.integratorCoefficient;
+
+    for (auto& group : stage.groups)
+    {
+        // Work on copies so the state stays in registers across the block
+        auto leftState1 = group.leftState1, leftState2 = group.leftState2;
+        auto rightState1 = group.rightState1, rightState2 = group.rightState2;
+        auto power = group.power;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto l = Vec::expand (left[i]);
+            auto r = Vec::expand (right[i]);
+
+            for (size_t k = 0; k < (size_t) numSections; ++k)
+            {
+                // b = gain * { 1, 0, -1 }
+                const auto gain = group.gains[k];
+                const auto xl = l, xr = r;
+
+                l = gain * xl + leftState1[k];
+                r = gain * xr + rightState1[k];
+
+                leftState1[k]  = leftState2[k]  - group.a1[k] * l;
+                rightState1[k] = rightState2[k] - group.a1[k] * r;
+
+                leftState2[k]  = zero - gain * xl - group.a2[k] * l;
+                rightState2[k] = zero - gain * xr - group.a2[k] * r;
+            }
+
+            const auto mid  = (l + r) * half;
+            const auto side = (l - r) * half;
+
+            power[0] = Vec::multiplyAdd (power[0], alpha, mid * mid - power[0]);
+            power[1] = Vec::multiplyAdd (power[1], alpha, l * l - power[1]);
+            power[2] = Vec::multiplyAdd (power[2], alpha, r * r - power[2]);
+            power[3] = Vec::multiplyAdd (power[3], alpha, side * side - power[3]);
+        }
+
+        group.leftState1 = leftState1;
+        group.leftState2 = leftState2;
+        group.rightState1 = rightState1;
+        group.rightState2 = rightState2;
+        group.power = power;
+    }
+
+    if (numDecimated > 0)
+        processStage (stageIndex + 1, stage.decimatedLeft.data(), stage.decimatedRight.data(), numDecimated);
+}
+
+void FractionalOctaveFilterBank::getBandMagnitudes (int view, float* bandMagnitudes) const noexcept
+{
+    jassert (juce::isPositiveAndBelow (view, numViews));
+
+    // RMS * sqrt (2) is a tone's amplitude; the FFT reads a quarter of that
+    const auto toneScale = std::sqrt (2.0f) * 0.25f;
+
+    for (const auto& stage : stages)
+        for (const auto& group : stage.groups)
+            for (int lane = 0; lane < group.numBands; ++lane)
+                bandMagnitudes[group.firstBand + lane] = std::sqrt (juce::jmax (0.0f, group.power[(size_t) view].get ((size_t) lane))) * toneScale;
+}
+
+//==============================================================================
+int FractionalOctaveFilterBank::getStageForBand (double highEdge, double sampleRate) noexcept
+{
+    // The slowest stage that still has the band inside the decimators' alias-free range
+    int stage = 0;
+
+    while (stage + 1 < maxStages && highEdge < 0.35 * sampleRate / (double) (2 << stage))
+        ++stage;
+
+    return stage;
+}
+
+void FractionalOctaveFilterBank::designBand (double lowEdge, double highEdge, double sampleRate,
+                                             std::array<double, numSections>& gains,
+                                             std::array<double, numSections>& a1,
+                                             std::array<double, numSections>& a2)
+{
+    constexpr auto pi = juce::MathConstants<double>::pi;
+
+    gains.fill (0.0);
+    a1.fill (0.0);
+    a2.fill (0.0);
+
+    // A band beyond Nyquist stays silent
+    highEdge = juce::jmin (highEdge, 0.49 * sampleRate);
+
+    if (lowEdge <= 0.0 || lowEdge >= highEdge)
+        return;
+
+    const auto prewarp = [sampleRate] (double frequency) { return 2.0 * sampleRate * std::tan (pi * frequency / sampleRate); };
+
+    const auto lowOmega = prewarp (lowEdge);
+    const auto highOmega = prewarp (highEdge);
+    const auto bandwidth = highOmega - lowOmega;
+    const auto centreSquared = lowOmega * highOmega;
+
+    // Where the analogue centre lands after the bilinear transform
+    const auto centre = std::polar (1.0, -2.0 * std::atan (std::sqrt (centreSquared) / (2.0 * sampleRate)));
+
+    size_t section = 0;
+
+    for (int k = 0; k < numSections; ++k)
+    {
+        // Butterworth prototype pole, moved to the band by s -> (s^2 + w0^2) / (B s): each
+        // becomes the roots of s^2 - p B s + w0^2, and the upper half plane's poles
+        // pair up with their conjugates into the sections
+        const auto pole = std::polar (1.0, pi * (double) (2 * k + numSections + 1) / (2.0 * numSections));
+        const auto root = std::sqrt (pole * pole * bandwidth * bandwidth - 4.0 * centreSquared);
+
+        for (const auto s : { (pole * bandwidth + root) * 0.5, (pole * bandwidth - root) * 0.5 })
+        {
+            if (s.imag() <= 0.0 || section >= (size_t) numSections)
+                continue;
+
+            const auto z = (2.0 * sampleRate + s) / (2.0 * sampleRate - s);
+
+            a1[section] = -2.0 * z.real();
+            a2[section] = std::norm (z);
+
+            // Unity gain at the centre for every section
+            const auto response = (1.0 - centre * centre) / (1.0 + a1[section] * centre + a2[section] * centre * centre);
+            gains[section] = 1.0 / std::abs (response);
+            ++section;
+        }
+    }
+
+    jassert (section == (size_t) numSections); // bands up to a couple of octaves wide
+}
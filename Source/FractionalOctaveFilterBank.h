@@ -0,0 +1,100 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "HalfBandDecimator.h"
+#include <array>
+#include <vector>
+
+//==============================================================================
+/**
+    Band levels from a bank of IIR band-pass filters, as an alternative to the
+    FFT. Every sample updates every band, so there's no frame to fill and the
+    display follows the signal as closely as the filters themselves allow.
+
+    Each band is a sixth-order Butterworth band-pass between its edges (three
+    biquads, the usual design for IEC 61260 fractional-octave filters), made
+    with the bilinear transform prewarped at both edges. Left and right are
+    filtered; mid and side are formed from the filtered pair, since the filters
+    are linear. Band power is averaged per sample by a one-pole integrator.
+
+    The signal runs down a chain of half-band decimators and each band is
+    filtered at the lowest rate that still holds it alias-free, so a band sits
+    in the top octave of its stage. That keeps the low bands' poles well away
+    from z = 1 in float, and makes the whole bank cost about twice its top
+    stage. Within a stage, bands are packed into SIMD lanes with one
+    coefficient per lane.
+*/
+class FractionalOctaveFilterBank
+{
+public:
+    static constexpr int numViews = 4; // in AnalysisFrame::SpectrumView order: mid, left, right, side
+    static constexpr int maxChunkSize = 1024;
+
+    FractionalOctaveFilterBank() = default;
+
+    /** Designs the filters for the bands between consecutive edges (edges.size() - 1
+        of them). Not realtime safe.
+    */
+    void prepare (double sampleRate, const std::vector<double>& bandEdges);
+
+    void reset() noexcept;
+
+    /** How long the band power takes to settle (time constant of the integrator). */
+    void setIntegrationTime (double seconds) noexcept;
+
+    /** Filters up to maxChunkSize samples of left and right. */
+    void process (const float* left, const float* right, int numSamples) noexcept;
+
+    /** Each band's RMS level in one view, scaled so that a tone reads as its
+        peak bin would in the FFT spectrum (a quarter of its amplitude).
+    */
+    void getBandMagnitudes (int view, float* bandMagnitudes) const noexcept;
+
+    int getNumBands() const noexcept                { return numBands; }
+    int getNumStages() const noexcept               { return (int) stages.size(); }
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    static constexpr int numSections = 3;
+    static constexpr int maxStages = 12;
+
+    // Up to Vec::size() bands of one stage; unused lanes have zero coefficients
+    struct BandGroup
+    {
+        int firstBand = 0, numBands = 0;
+
+        // Per section, with numerator gain * (1 - z^-2)
+        std::array<Vec, numSections> gains, a1, a2;
+
+        // Transposed direct form II state per section, for left and right
+        std::array<Vec, numSections> leftState1, leftState2, rightState1, rightState2;
+
+        std::array<Vec, numViews> power;
+    };
+
+    struct Stage
+    {
+        double sampleRate = 0.0;
+        Vec integratorCoefficient;
+        std::vector<BandGroup> groups;
+
+        // Produce the next stage's input from this stage's
+        HalfBandDecimator decimatorLeft, decimatorRight;
+        std::vector<float> decimatedLeft, decimatedRight;
+    };
+
+    static int getStageForBand (double highEdge, double sampleRate) noexcept;
+    static void designBand (double lowEdge, double highEdge, double sampleRate,
+                            std::array<double, numSections>& gains,
+                            std::array<double, numSections>& a1,
+                            std::array<double, numSections>& a2);
+
+    void processStage (int stageIndex, const float* left, const float* right, int numSamples) noexcept;
+
+    std::vector<Stage> stages;
+    int numBands = 0;
+    double integrationTime = 0.125;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FractionalOctaveFilterBank)
+};
@@ -0,0 +1,387 @@
+#include "GifDecoder.h"
+#include <array>
+
+namespace GifDecoder
+{
+namespace
+{
+    //==============================================================================
+    class ByteReader
+    {
+    public:
+        ByteReader (const void* d, size_t n) noexcept
+            : data (static_cast<const uint8_t*> (d)), size (n) {}
+
+        bool hasBytes (size_t n) const noexcept     { return position + n <= size; }
+        uint8_t readByte() noexcept                 { return position < size ? data[position++] : 0; }
+        int readShort() noexcept                    { const int lo = readByte(); return lo | (readByte() << 8); }
+        void skip (size_t n) noexcept               { position = std::min (size, position + n); }
+
+        void readColourTable (int numColours, std::array<juce::PixelARGB, 256>& table) noexcept
+        {
+            for (int i = 0; i < numColours; ++i)
+            {
+                const auto r = readByte();
+                const auto g = readByte();
+                const auto b = readByte();
+                table[(size_t) i] = juce::PixelARGB (255, r, g, b);
+            }
+        }
+
+        /** Reads a chain of data sub-blocks, appending their payload to dest if given. */
+        void readSubBlocks (std::vector<uint8_t>* dest)
+        {
+            for (;;)
+            {
+                const auto blockSize = (size_t) readByte();
+
+                if (blockSize == 0 || ! hasBytes (blockSize))
+                    return;
+
+                if (dest != nullptr)
+                    dest->insert (dest->end(), data + position, data + position + blockSize);
+
+                position += blockSize;
+            }
+        }
+
+    private:
+        const uint8_t* data;
+        size_t size;
+        size_t position = 0;
+    };
+
+    //==============================================================================
+    /** Expands LZW-coded image data into colour indices; returns false on corrupt data. */
+    bool decodeLzw (const std::vector<uint8_t>& input, int minCodeSize, std::vector<uint8_t>& output)
+    {
+        constexpr int maxCodes = 4096;
+
+        if (minCodeSize < 2 || minCodeSize > 11)
+            return false;
+
+        std::array<int16_t, maxCodes> prefix;
+        std::array<uint8_t, maxCodes> suffix;
+        std::array<uint8_t, maxCodes + 1> stack;
+
+        const int clearCode = 1 << minCodeSize;
+        const int endCode   = clearCode + 1;
+
+        for (int i = 0; i < clearCode; ++i)
+        {
+            prefix[(size_t) i] = -1;
+            suffix[(size_t) i] = (uint8_t) i;
+        }
+
+        int codeSize = minCodeSize + 1;
+        int nextCode = endCode + 1;
+        int previousCode = -1;
+        uint8_t firstByte = 0;
+
+        uint32_t bitBuffer = 0;
+        int numBits = 0;
+        size_t inputPosition = 0;
+        size_t outputPosition = 0;
+
+        while (outputPosition < output.size())
+        {
+            while (numBits < codeSize && inputPosition < input.size())
+            {
+                bitBuffer |= (uint32_t) input[inputPosition++] << numBits;
+                numBits += 8;
+            }
+
+            if (numBits < codeSize)
+                break;
+
+            int code = (int) (bitBuffer & ((1u << codeSize) - 1));
+            bitBuffer >>= codeSize;
+            numBits -= codeSize;
+
+            if (code == clearCode)
+            {
+                codeSize = minCodeSize + 1;
+                nextCode = endCode + 1;
+                previousCode = -1;
+                continue;
+            }
+
+            if (code == endCode)
+                break;
+
+            if (previousCode < 0)
+            {
+                if (code >= clearCode)
+                    return false;
+
+                firstByte = (uint8_t) code;
+                output[outputPosition++] = firstByte;
+                previousCode = code;
+                continue;
+            }
+
+            const int incomingCode = code;
+            size_t stackSize = 0;
+
+            if (code >= nextCode)
+            {
+                if (code > nextCode)
+                    return false;
+
+                // The code being defined right now: previous string + its own first byte
+                stack[stackSize++] = firstByte;
+                code = previousCode;
+            }
+
+            while (code >= clearCode)
+            {
+                if (stackSize >= (size_t) maxCodes)
+                    return false;
+
+                stack[stackSize++] = suffix[(size_t) code];
+                code = prefix[(size_t) code];
+            }
+
+            firstByte = (uint8_t) code;
+            stack[stackSize++] = firstByte;
+
+            while (stackSize > 0 && outputPosition < output.size())
+                output[outputPosition++] = stack[--stackSize];
+
+            if (nextCode < maxCodes)
+            {
+                prefix[(size_t) nextCode] = (int16_t) previousCode;
+                suffix[(size_t) nextCode] = firstByte;
+                ++nextCode;
+
+                if (nextCode == (1 << codeSize) && codeSize < 12)
+                    ++codeSize;
+            }
+
+            previousCode = incomingCode;
+        }
+
+        // Truncated streams are common; whatever is missing stays at index 0
+        return true;
+    }
+
+    //==============================================================================
+    struct Canvas
+    {
+        int width = 0, height = 0;
+        std::vector<juce::PixelARGB> pixels;
+
+        juce::Image toImage() const
+        {
+            juce::Image image (juce::SoftwareImageType().create (juce::Image::ARGB, width, height, true));
+            juce::Image::BitmapData bitmap (image, juce::Image::BitmapData::writeOnly);
+
+            for (int y = 0; y < height; ++y)
+                for (int x = 0; x < width; ++x)
+                    reinterpret_cast<juce::PixelARGB*> (bitmap.getPixelPointer (x, y))->set (pixels[(size_t) (y * width + x)]);
+
+            return image;
+        }
+
+        void clear (juce::Rectangle<int> area)
+        {
+            area = area.getIntersection ({ width, height });
+
+            for (int y = area.getY(); y < area.getBottom(); ++y)
+                for (int x = area.getX(); x < area.getRight(); ++x)
+                    pixels[(size_t) (y * width + x)] = juce::PixelARGB (0, 0, 0, 0);
+        }
+    };
+
+    // Row order of the four interlace passes
+    int getInterlacedRow (int index, int height) noexcept
+    {
+        const int pass1 = (height + 7) / 8;
+        const int pass2 = (height + 3) / 8;
+        const int pass3 = (height + 1) / 4;
+
+        if (index < pass1)                    return index * 8;
+        index -= pass1;
+        if (index < pass2)                    return index * 8 + 4;
+        index -= pass2;
+        if (index < pass3)                    return index * 4 + 2;
+        index -= pass3;
+        return index * 2 + 1;
+    }
+}
+
+//==============================================================================
+std::vector<Frame> decode (const void* data, size_t numBytes, size_t memoryBudgetBytes)
+{
+    std::vector<Frame> frames;
+
+    if (data == nullptr || numBytes < 13)
+        return frames;
+
+    ByteReader reader (data, numBytes);
+
+    char signature[6];
+    for (auto& c : signature)
+        c = (char) reader.readByte();
+
+    if (juce::String (signature, 3) != "GIF")
+        return frames;
+
+    Canvas canvas;
+    canvas.width  = reader.readShort();
+    canvas.height = reader.readShort();
+
+    if (canvas.width <= 0 || canvas.height <= 0 || canvas.width > 4096 || canvas.height > 4096)
+        return frames;
+
+    canvas.pixels.assign ((size_t) (canvas.width * canvas.height), juce::PixelARGB (0, 0, 0, 0));
+
+    const auto screenFlags = reader.readByte();
+    reader.skip (2); // background colour index, pixel aspect ratio
+
+    std::array<juce::PixelARGB, 256> globalColours {};
+    const bool hasGlobalColours = (screenFlags & 0x80) != 0;
+
+    if (hasGlobalColours)
+        reader.readColourTable (2 << (screenFlags & 7), globalColours);
+
+    // Graphic control state for the next image
+    int delayCentiseconds = 0;
+    int transparentIndex = -1;
+    int disposal = 0;
+
+    // How to clean up after the previous image before drawing the next one
+    int previousDisposal = 0;
+    juce::Rectangle<int> previousArea;
+    std::vector<juce::PixelARGB> savedPixels;
+
+    std::vector<uint8_t> lzwData, indices;
+
+    // Frames are kept at multiples of keepEvery; the rest add their time to the one before
+    const auto bytesPerFrame = canvas.pixels.size() * sizeof (juce::PixelARGB);
+    int keepEvery = 1, numDecoded = 0;
+
+    while (reader.hasBytes (1))
+    {
+        const auto blockType = reader.readByte();
+
+        if (blockType == 0x3b) // trailer
+            break;
+
+        if (blockType == 0x21) // extension
+        {
+            const auto label = reader.readByte();
+
+            if (label == 0xf9 && reader.hasBytes (6))
+            {
+                reader.skip (1); // block size, always 4
+                const auto flags = reader.readByte();
+                delayCentiseconds = reader.readShort();
+                const auto index = reader.readByte();
+
+                disposal = (flags >> 2) & 7;
+                transparentIndex = (flags & 1) != 0 ? (int) index : -1;
+            }
+
+            reader.readSubBlocks (nullptr);
+            continue;
+        }
+
+        if (blockType != 0x2c) // anything but an image descriptor is corrupt
+            break;
+
+        if (! reader.hasBytes (9))
+            break;
+
+        // Read in sequence: argument evaluation order is unspecified
+        const int left   = reader.readShort();
+        const int top    = reader.readShort();
+        const int width  = reader.readShort();
+        const int height = reader.readShort();
+        const juce::Rectangle<int> area (left, top, width, height);
+        const auto imageFlags = reader.readByte();
+
+        std::array<juce::PixelARGB, 256> localColours {};
+        const bool hasLocalColours = (imageFlags & 0x80) != 0;
+
+        if (hasLocalColours)
+            reader.readColourTable (2 << (imageFlags & 7), localColours);
+
+        const auto& colours = hasLocalColours ? localColours : globalColours;
+        const bool interlaced = (imageFlags & 0x40) != 0;
+        const int minCodeSize = reader.readByte();
+
+        lzwData.clear();
+        reader.readSubBlocks (&lzwData);
+
+        if (area.isEmpty())
+            continue;
+
+        indices.assign ((size_t) (area.getWidth() * area.getHeight()), 0);
+
+        if (! decodeLzw (lzwData, minCodeSize, indices))
+            break;
+
+        // Undo the previous frame as its disposal method asks
+        if (previousDisposal == 2)
+            canvas.clear (previousArea);
+        else if (previousDisposal == 3 && savedPixels.size() == canvas.pixels.size())
+            canvas.pixels = savedPixels;
+
+        if (disposal == 3)
+            savedPixels = canvas.pixels;
+
+        for (int row = 0; row < area.getHeight(); ++row)
+        {
+            const int y = area.getY() + (interlaced ? getInterlacedRow (row, area.getHeight()) : row);
+
+            if (y >= canvas.height)
+                continue;
+
+            const auto* rowIndices = indices.data() + (size_t) (row * area.getWidth());
+
+            for (int col = 0; col < area.getWidth(); ++col)
+            {
+                const int x = area.getX() + col;
+                const int index = rowIndices[col];
+
+                if (x < canvas.width && index != transparentIndex)
+                    canvas.pixels[(size_t) (y * canvas.width + x)] = colours[(size_t) index];
+            }
+        }
+
+        // Browsers treat delays under 20 ms as 100 ms; so do we
+        const auto duration = delayCentiseconds < 2 ? 0.1 : delayCentiseconds / 100.0;
+
+        if (numDecoded++ % keepEvery == 0)
+            frames.push_back ({ canvas.toImage(), duration });
+        else
+            frames.back().durationSeconds += duration;
+
+        // Over budget: drop every other frame kept so far, and keep half as many from here on
+        if (frames.size() > 1 && frames.size() * bytesPerFrame > memoryBudgetBytes)
+        {
+            for (size_t i = 0; i < frames.size(); i += 2)
+            {
+                if (i + 1 < frames.size())
+                    frames[i].durationSeconds += frames[i + 1].durationSeconds;
+
+                if (i > 0)
+                    frames[i / 2] = std::move (frames[i]);
+            }
+
+            frames.resize ((frames.size() + 1) / 2);
+            keepEvery *= 2;
+        }
+
+        previousDisposal = disposal;
+        previousArea = area;
+
+        delayCentiseconds = 0;
+        transparentIndex = -1;
+        disposal = 0;
+    }
+
+    return frames;
+}
+}
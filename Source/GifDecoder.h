@@ -0,0 +1,33 @@
+#pragma once
+
+#include <juce_graphics/juce_graphics.h>
+#include <limits>
+#include <vector>
+
+//==============================================================================
+/**
+    Decodes every frame of an animated GIF.
+
+    juce::GIFImageFormat only returns the first frame, so this does its own
+    block parsing and LZW decoding. Frames are composited onto the logical
+    screen according to their disposal method, so each returned image is a
+    complete picture. Images are created as software images, which makes
+    decode() safe to call from a background thread.
+*/
+namespace GifDecoder
+{
+    struct Frame
+    {
+        juce::Image image;
+        double durationSeconds = 0.1;
+    };
+
+    /** Returns an empty vector if the data isn't a GIF or has no readable frames.
+
+        If keeping every frame would take more than memoryBudgetBytes, only every
+        n-th frame is kept (with n a power of two), and it inherits the display
+        time of the frames it replaces. The first frame is always kept.
+    */
+    std::vector<Frame> decode (const void* data, size_t numBytes,
+                               size_t memoryBudgetBytes = std::numeric_limits<size_t>::max());
+}
@@ -0,0 +1,49 @@
+#include "GifFrameAtlas.h"
+
+GifFrameAtlas::GifFrameAtlas (const std::vector<GifDecoder::Frame>& frames,
+                              int width, int height, size_t memoryBudgetBytes)
+    : frameWidth (juce::jlimit (1, maxImageDimension, width)),
+      frameHeight (juce::jlimit (1, maxImageDimension, height))
+{
+    if (frames.empty())
+        return;
+
+    framesPerRow = juce::jmax (1, maxImageDimension / frameWidth);
+
+    const auto bytesPerFrame = (size_t) frameWidth * (size_t) frameHeight * 4;
+    const auto maxFrames = juce::jmax (1, juce::jmin ((int) (memoryBudgetBytes / bytesPerFrame),
+                                                      framesPerRow * (maxImageDimension / frameHeight)));
+
+    const auto numSourceFrames = (int) frames.size();
+    const auto stride = (numSourceFrames + maxFrames - 1) / maxFrames;
+    const auto numFrames = (numSourceFrames + stride - 1) / stride;
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        double duration = 0.0;
+
+        for (int source = i * stride; source < juce::jmin (numSourceFrames, (i + 1) * stride); ++source)
+            duration += frames[(size_t) source].durationSeconds;
+
+        frameDurations.push_back (duration);
+    }
+
+    framesPerRow = juce::jmin (framesPerRow, numFrames);
+    const auto numRows = (numFrames + framesPerRow - 1) / framesPerRow;
+
+    image = juce::SoftwareImageType().create (juce::Image::ARGB, framesPerRow * frameWidth, numRows * frameHeight, true);
+
+    juce::Graphics g (image);
+    g.setImageResamplingQuality (juce::Graphics::highResamplingQuality);
+
+    for (int i = 0; i < numFrames; ++i)
+        g.drawImage (frames[(size_t) (i * stride)].image, getFrameArea (i).toFloat(),
+                     juce::RectanglePlacement::stretchToFit);
+}
+
+juce::Rectangle<int> GifFrameAtlas::getFrameArea (int frameIndex) const noexcept
+{
+    return { (frameIndex % framesPerRow) * frameWidth,
+             (frameIndex / framesPerRow) * frameHeight,
+             frameWidth, frameHeight };
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "GifDecoder.h"
+
+//==============================================================================
+/**
+    All frames of a GIF pre-scaled to one size and packed into a single image,
+    so drawing a frame is a plain copy of a sub-rectangle.
+
+    Building is self-contained and safe on a background thread. If the frames
+    don't fit into the memory budget, only every n-th frame is kept, and it
+    inherits the display time of the frames it replaces.
+*/
+class GifFrameAtlas
+{
+public:
+    GifFrameAtlas (const std::vector<GifDecoder::Frame>& frames,
+                   int frameWidth, int frameHeight, size_t memoryBudgetBytes);
+
+    int getNumFrames() const noexcept                           { return (int) frameDurations.size(); }
+    juce::Rectangle<int> getFrameSize() const noexcept          { return { frameWidth, frameHeight }; }
+    const juce::Image& getImage() const noexcept                { return image; }
+
+    juce::Rectangle<int> getFrameArea (int frameIndex) const noexcept;
+    double getFrameDuration (int frameIndex) const noexcept     { return frameDurations[(size_t) frameIndex]; }
+
+private:
+    // Keeps the atlas below texture size limits of the GPU-backed renderers
+    static constexpr int maxImageDimension = 8192;
+
+    int frameWidth = 0, frameHeight = 0, framesPerRow = 1;
+    juce::Image image;
+    std::vector<double> frameDurations;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GifFrameAtlas)
+};
@@ -0,0 +1,41 @@
+#include "GoniometerBuffer.h"
+
+GoniometerBuffer::GoniometerBuffer()
+    : points ((size_t) capacity, Point { 0.0f, 0.0f })
+{
+}
+
+void GoniometerBuffer::prepare (double sampleRate) noexcept
+{
+    decimation = juce::jmax (1, juce::roundToInt (sampleRate / targetPointRate));
+    reset();
+}
+
+void GoniometerBuffer::reset() noexcept
+{
+    samplesToNextPoint = 0;
+    resetPending.store (true, std::memory_order_release);
+}
+
+void GoniometerBuffer::push (const float* left, const float* right, int numSamples) noexcept
+{
+    if (samplesToNextPoint >= numSamples)
+    {
+        samplesToNextPoint -= numSamples;
+        return;
+    }
+
+    const auto numPoints = 1 + (numSamples - 1 - samplesToNextPoint) / decimation;
+    const auto scope = fifo.write (juce::jmin (numPoints, fifo.getFreeSpace()));
+
+    auto sample = samplesToNextPoint;
+
+    scope.forEach ([&] (int index)
+    {
+        points[(size_t) index] = { left[sample], right[sample] };
+        sample += decimation;
+    });
+
+    // Keep the spacing even when points were dropped
+    samplesToNextPoint = samplesToNextPoint + numPoints * decimation - numSamples;
+}
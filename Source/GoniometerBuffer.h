@@ -0,0 +1,79 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+/**
+    Hands decimated left/right sample pairs from the analysis side to one
+    reader (the editor's goniometer).
+
+    Plotting every sample at high rates would give the reader far more points
+    than it can use, so only every n-th pair is kept, with n chosen from the
+    sample rate to give about targetPointRate points a second. No filtering is
+    needed: each point is an instantaneous pair, and a thinned-out cloud of
+    them has the same shape. Points that don't fit while the reader is behind
+    are dropped.
+
+    Like SpectrogramBuffer, clearing it only leaves a request for the reader,
+    which drops the points that came before it at the start of its next read.
+*/
+class GoniometerBuffer
+{
+public:
+    struct Point
+    {
+        float left, right;
+    };
+
+    static constexpr double targetPointRate = 24000.0;
+
+    // About two thirds of a second of points; the editor drains it every frame
+    static constexpr int capacity = 16384;
+
+    GoniometerBuffer();
+
+    /** Writer: picks the decimation for a sample rate and clears the buffer. Call it
+        from the writer's thread, or while the writer isn't running.
+    */
+    void prepare (double sampleRate) noexcept;
+
+    /** Writer: clears the buffer, as prepare() does. */
+    void reset() noexcept;
+
+    int getDecimation() const noexcept                  { return decimation; }
+
+    /** Writer: adds every getDecimation()-th pair, counting on across calls. */
+    void push (const float* left, const float* right, int numSamples) noexcept;
+
+    /** Reader: calls callback (const Point* points, int numPoints) on the points
+        pushed since the last call, oldest first, and returns how many there were.
+    */
+    template <typename Callback>
+    int readAll (Callback&& callback)
+    {
+        if (resetPending.exchange (false, std::memory_order_acquire))
+            fifo.finishedRead (fifo.getNumReady());
+
+        const auto scope = fifo.read (fifo.getNumReady());
+
+        if (scope.blockSize1 > 0)
+            callback (points.data() + scope.startIndex1, scope.blockSize1);
+
+        if (scope.blockSize2 > 0)
+            callback (points.data() + scope.startIndex2, scope.blockSize2);
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::vector<Point> points;
+    std::atomic<bool> resetPending { false };
+
+    int decimation = 1;
+    int samplesToNextPoint = 0; // writer only
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GoniometerBuffer)
+};
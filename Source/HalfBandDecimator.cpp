@@ -0,0 +1,62 @@
+#include "HalfBandDecimator.h"
+#include <cmath>
+
+HalfBandDecimator::HalfBandDecimator() noexcept
+{
+    // Blackman-windowed sinc with its cutoff at a quarter of the input rate. The
+    // centre tap is 0.5; the side taps are rescaled so the DC gain is exactly one.
+    const double pi = 3.14159265358979323846;
+    double sideSum = 0.0;
+
+    for (int i = 0; i < numSideTaps; ++i)
+    {
+        const int offset = 2 * i + 1;
+        const double n = (double) (centreTap + offset);
+        const double window = 0.42 - 0.5 * std::cos (2.0 * pi * n / (numTaps - 1))
+                                   + 0.08 * std::cos (4.0 * pi * n / (numTaps - 1));
+        const double sinc = std::sin (pi * offset * 0.5) / (pi * offset);
+
+        sideCoefficients[(size_t) i] = (float) (sinc * window);
+        sideSum += sinc * window;
+    }
+
+    for (auto& c : sideCoefficients)
+        c = (float) (c * 0.25 / sideSum);
+}
+
+void HalfBandDecimator::reset() noexcept
+{
+    history.fill (0.0f);
+    writeIndex = 0;
+    skipNextOutput = false;
+}
+
+int HalfBandDecimator::process (const float* input, int numInputSamples, float* output) noexcept
+{
+    int numOutputs = 0;
+
+    for (int i = 0; i < numInputSamples; ++i)
+    {
+        history[(size_t) writeIndex] = history[(size_t) (writeIndex + numTaps)] = input[i];
+        writeIndex = (writeIndex + 1 == numTaps) ? 0 : writeIndex + 1;
+
+        skipNextOutput = ! skipNextOutput;
+
+        if (! skipNextOutput)
+            continue;
+
+        // The last numTaps samples, oldest first
+        const float* x = history.data() + writeIndex;
+        float sum = 0.5f * x[centreTap];
+
+        for (int tap = 0; tap < numSideTaps; ++tap)
+        {
+            const int offset = 2 * tap + 1;
+            sum += sideCoefficients[(size_t) tap] * (x[centreTap - offset] + x[centreTap + offset]);
+        }
+
+        output[numOutputs++] = sum;
+    }
+
+    return numOutputs;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+
+//==============================================================================
+/**
+    Decimates a signal by two with a linear-phase half-band FIR.
+
+    Every other tap of a half-band filter is zero, so each output only costs
+    (numTaps + 1) / 4 multiply-adds on symmetric pairs plus the centre tap, and
+    outputs are only computed for the samples that are kept. Everything above
+    0.35 of the input rate is down by more than 80 dB, so the lower 35% of the
+    output band is alias-free as far as the analyzer's display is concerned.
+*/
+class HalfBandDecimator
+{
+public:
+    HalfBandDecimator() noexcept;
+
+    void reset() noexcept;
+
+    /** Consumes numInputSamples and writes one output for every second input.
+        Returns how many samples were written to output (at most
+        (numInputSamples + 1) / 2). input and output may not overlap.
+    */
+    int process (const float* input, int numInputSamples, float* output) noexcept;
+
+private:
+    static constexpr int numSideTaps = 12;                  // non-zero taps either side of the centre
+    static constexpr int numTaps     = numSideTaps * 4 - 1; // 47
+    static constexpr int centreTap   = numTaps / 2;
+
+    std::array<float, numSideTaps> sideCoefficients {};
+
+    // Each sample is written twice, numTaps apart, so the current window is always contiguous
+    std::array<float, numTaps * 2> history {};
+    int writeIndex = 0;
+    bool skipNextOutput = false;
+};
@@ -0,0 +1,162 @@
+#include "LoadProfiler.h"
+#include <cmath>
+
+const char* LoadProfiler::getSectionName (Section section) noexcept
+{
+    switch (section)
+    {
+        case Section::processBlock:     return "processBlock";
+        case Section::fftFrame:         return "fftFrame";
+    }
+
+    return "";
+}
+
+//==============================================================================
+void LoadProfiler::record (Section section, juce::int64 elapsedTicks, double budgetSeconds) noexcept
+{
+    auto& histograms = sections[(size_t) section];
+
+    if (histograms.resetPending.load (std::memory_order_relaxed) && histograms.resetPending.exchange (false))
+    {
+        histograms.micros.clear();
+        histograms.load.clear();
+    }
+
+    const auto seconds = juce::Time::highResolutionTicksToSeconds (elapsedTicks);
+
+    histograms.micros.add (seconds * 1.0e6);
+
+    if (budgetSeconds > 0.0)
+        histograms.load.add (seconds / budgetSeconds);
+}
+
+LoadProfiler::Summary LoadProfiler::getSummary (Section section) const noexcept
+{
+    const auto& histograms = sections[(size_t) section];
+
+    Summary summary;
+    summary.count     = histograms.micros.getCount();
+    summary.p50Micros = histograms.micros.getPercentile (0.5);
+    summary.p99Micros = histograms.micros.getPercentile (0.99);
+    summary.maxMicros = histograms.micros.getMax();
+    summary.p50Load   = histograms.load.getPercentile (0.5);
+    summary.p99Load   = histograms.load.getPercentile (0.99);
+    summary.maxLoad   = histograms.load.getMax();
+    return summary;
+}
+
+void LoadProfiler::reset() noexcept
+{
+    for (auto& histograms : sections)
+        histograms.resetPending.store (true);
+}
+
+juce::String LoadProfiler::toJson() const
+{
+    auto* root = new juce::DynamicObject();
+
+    for (int i = 0; i < numSections; ++i)
+    {
+        const auto section = (Section) i;
+        const auto summary = getSummary (section);
+        const auto& histograms = sections[(size_t) i];
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty ("count", (juce::int64) summary.count);
+        entry->setProperty ("p50Micros", summary.p50Micros);
+        entry->setProperty ("p99Micros", summary.p99Micros);
+        entry->setProperty ("maxMicros", summary.maxMicros);
+        entry->setProperty ("p50Load", summary.p50Load);
+        entry->setProperty ("p99Load", summary.p99Load);
+        entry->setProperty ("maxLoad", summary.maxLoad);
+        entry->setProperty ("microsHistogram", histograms.micros.toVar());
+        entry->setProperty ("loadHistogram", histograms.load.toVar());
+
+        root->setProperty (getSectionName (section), juce::var (entry));
+    }
+
+    return juce::JSON::toString (juce::var (root));
+}
+
+//==============================================================================
+void LoadProfiler::Histogram::add (double value) noexcept
+{
+    // One writer, so plain load/store would do; fetch_add keeps readers' snapshots whole
+    bins[(size_t) getBin (value)].fetch_add (1, std::memory_order_relaxed);
+    count.fetch_add (1, std::memory_order_relaxed);
+
+    if (value > maxValue.load (std::memory_order_relaxed))
+        maxValue.store (value, std::memory_order_relaxed);
+}
+
+void LoadProfiler::Histogram::clear() noexcept
+{
+    for (auto& bin : bins)
+        bin.store (0, std::memory_order_relaxed);
+
+    count.store (0, std::memory_order_relaxed);
+    maxValue.store (0.0, std::memory_order_relaxed);
+}
+
+int LoadProfiler::Histogram::getBin (double value) const noexcept
+{
+    if (! (value > minValue))
+        return 0;
+
+    // value / minValue = mantissa * 2^exponent with mantissa in [0.5, 1): the exponent
+    // picks the octave and the mantissa the linear step within it
+    int exponent = 0;
+    const auto mantissa = std::frexp (value / minValue, &exponent);
+    const auto step = (int) ((mantissa * 2.0 - 1.0) * stepsPerOctave);
+
+    return juce::jmin (numBins - 1, (exponent - 1) * stepsPerOctave + step);
+}
+
+double LoadProfiler::Histogram::getBinValue (int bin) const noexcept
+{
+    const auto octave = bin / stepsPerOctave;
+    const auto step = bin % stepsPerOctave;
+
+    return minValue * std::ldexp (1.0 + (step + 0.5) / stepsPerOctave, octave);
+}
+
+double LoadProfiler::Histogram::getPercentile (double fraction) const noexcept
+{
+    std::array<juce::uint32, numBins> snapshot;
+    juce::uint64 total = 0;
+
+    for (size_t i = 0; i < snapshot.size(); ++i)
+    {
+        snapshot[i] = bins[i].load (std::memory_order_relaxed);
+        total += snapshot[i];
+    }
+
+    if (total == 0)
+        return 0.0;
+
+    const auto target = (juce::uint64) std::ceil (fraction * (double) total);
+    juce::uint64 seen = 0;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        seen += snapshot[(size_t) bin];
+
+        if (seen >= target)
+            return juce::jmin (getBinValue (bin), getMax());
+    }
+
+    return getMax();
+}
+
+juce::var LoadProfiler::Histogram::toVar() const
+{
+    // Sparse: [value, count] pairs for the bins that have anything in them
+    juce::Array<juce::var> entries;
+
+    for (int bin = 0; bin < numBins; ++bin)
+        if (const auto binCount = bins[(size_t) bin].load (std::memory_order_relaxed); binCount > 0)
+            entries.add (juce::Array<juce::var> { getBinValue (bin), (juce::int64) binCount });
+
+    return entries;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+//==============================================================================
+/**
+    Where the plugin's time goes, cheap enough to leave running in a session.
+
+    Each timed section keeps two fixed histograms: how long the work took, and
+    what fraction of its time budget it used (the real-time length of the block
+    or frame it handled). Bins are a power of two wide with eight linear steps
+    in each, so percentiles are good to a few percent from nanoseconds to
+    seconds. Recording costs two tick reads and a few relaxed atomic adds, with
+    no allocation or locks; each section may only have one writer at a time.
+    Readers on any thread take p50 / p99 / max from a snapshot of the counts.
+*/
+class LoadProfiler
+{
+public:
+    enum class Section
+    {
+        processBlock,
+        fftFrame
+    };
+
+    static constexpr int numSections = 2;
+    static const char* getSectionName (Section) noexcept;
+
+    struct Summary
+    {
+        juce::uint64 count = 0;
+        double p50Micros = 0.0, p99Micros = 0.0, maxMicros = 0.0;
+        double p50Load = 0.0, p99Load = 0.0, maxLoad = 0.0; // fractions of the budget
+    };
+
+    LoadProfiler() = default;
+
+    //==============================================================================
+    /** Writer: one measurement. budgetSeconds is the real time the work stands for. */
+    void record (Section, juce::int64 elapsedTicks, double budgetSeconds) noexcept;
+
+    /** Times its own lifetime into a section. */
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer (LoadProfiler& p, Section s, double budget) noexcept
+            : profiler (p), section (s), budgetSeconds (budget), startTicks (juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedTimer() noexcept     { profiler.record (section, juce::Time::getHighResolutionTicks() - startTicks, budgetSeconds); }
+
+    private:
+        LoadProfiler& profiler;
+        const Section section;
+        const double budgetSeconds;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedTimer)
+    };
+
+    //==============================================================================
+    Summary getSummary (Section) const noexcept;
+
+    /** Any thread: each section starts over at its next measurement. */
+    void reset() noexcept;
+
+    /** Every section's summary and non-empty bins as JSON, for comparing sessions. */
+    juce::String toJson() const;
+
+private:
+    //==============================================================================
+    class Histogram
+    {
+    public:
+        explicit Histogram (double smallestValue) noexcept : minValue (smallestValue) {}
+
+        void add (double value) noexcept;
+        void clear() noexcept;
+
+        juce::uint64 getCount() const noexcept      { return count.load (std::memory_order_relaxed); }
+        double getMax() const noexcept              { return maxValue.load (std::memory_order_relaxed); }
+
+        /** The bin midpoint at or below which `fraction` of the values lie. */
+        double getPercentile (double fraction) const noexcept;
+
+        juce::var toVar() const;
+
+    private:
+        static constexpr int stepsPerOctave = 8;
+        static constexpr int numOctaves = 32;
+        static constexpr int numBins = stepsPerOctave * numOctaves;
+
+        const double minValue;
+        std::array<std::atomic<juce::uint32>, numBins> bins {};
+        std::atomic<juce::uint64> count { 0 };
+        std::atomic<double> maxValue { 0.0 };
+
+        int getBin (double value) const noexcept;
+        double getBinValue (int bin) const noexcept;
+    };
+
+    struct SectionHistograms
+    {
+        Histogram micros { 0.01 };  // 10 ns up to about 40 s
+        Histogram load { 1.0e-6 };  // up to a few thousand times the budget
+        std::atomic<bool> resetPending { false };
+    };
+
+    std::array<SectionHistograms, numSections> sections;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoadProfiler)
+};
@@ -0,0 +1,366 @@
+#include "LoudnessMeter.h"
+#include <cmath>
+
+namespace
+{
+    double powerToLoudness (double power) noexcept
+    {
+        return power > 0.0 ? -0.691 + 10.0 * std::log10 (power) : (double) LoudnessMeter::minLoudness;
+    }
+
+    constexpr int stateMagic   = 0x4c55464e; // "LUFN"
+    constexpr int stateVersion = 1;
+}
+
+//==============================================================================
+void LoudnessMeter::prepare (double sampleRate, const std::vector<float>& channelWeights)
+{
+    numChannels = juce::jmin ((int) channelWeights.size(), maxChannels);
+    numGroups = (numChannels + lanes - 1) / lanes;
+
+    weights.fill (0.0);
+    std::copy (channelWeights.begin(), channelWeights.begin() + numChannels, weights.begin());
+
+    // BS.1770 K-weighting: a +4 dB high shelf for the head, then an RLB high-pass.
+    // The standard only lists 48 kHz coefficients; these are the analogue
+    // prototypes they come from, so every rate gets the same response.
+    const double pi = 3.14159265358979323846;
+
+    {
+        const double f0 = 1681.974450955533;
+        const double gainDb = 3.999843853973347;
+        const double q = 0.7071752369554196;
+
+        const double k  = std::tan (pi * f0 / sampleRate);
+        const double vh = std::pow (10.0, gainDb / 20.0);
+        const double vb = std::pow (vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        highShelf.b0 = (vh + vb * k / q + k * k) / a0;
+        highShelf.b1 = 2.0 * (k * k - vh) / a0;
+        highShelf.b2 = (vh - vb * k / q + k * k) / a0;
+        highShelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        highShelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+
+        const double k  = std::tan (pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+
+        highPass.b0 = 1.0;
+        highPass.b1 = -2.0;
+        highPass.b2 = 1.0;
+        highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+        highPass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    subBlockLength = juce::jmax (1, juce::roundToInt (sampleRate * 0.1));
+    reset();
+}
+
+void LoudnessMeter::reset() noexcept
+{
+    for (auto& group : groups)
+    {
+        group.state.fill (Vec::expand (0.0));
+        group.sumSquares = Vec::expand (0.0);
+    }
+
+    subBlockPosition = 0;
+    subBlockPowers.fill (0.0);
+    subBlockIndex = 0;
+    numSubBlocks = 0;
+
+    momentaryLoudness = minLoudness;
+    shortTermLoudness = minLoudness;
+}
+
+void LoudnessMeter::resetIntegration() noexcept
+{
+    for (auto& count : momentaryHistogram)
+        count.store (0, std::memory_order_relaxed);
+
+    for (auto& count : shortTermHistogram)
+        count.store (0, std::memory_order_relaxed);
+
+    histogramVersion.fetch_add (1, std::memory_order_release);
+}
+
+//==============================================================================
+template <typename SampleType>
+void LoudnessMeter::process (const SampleType* const* channels, int numInputChannels, int numSamples) noexcept
+{
+    numInputChannels = juce::jmin (numInputChannels, numChannels);
+
+    const auto shelfB0 = Vec::expand (highShelf.b0), shelfB1 = Vec::expand (highShelf.b1), shelfB2 = Vec::expand (highShelf.b2);
+    const auto shelfA1 = Vec::expand (highShelf.a1), shelfA2 = Vec::expand (highShelf.a2);
+    const auto passA1  = Vec::expand (highPass.a1),  passA2  = Vec::expand (highPass.a2);
+    const auto minusTwo = Vec::expand (-2.0);
+    auto* tileValues = reinterpret_cast<double*> (tile.data());
+
+    for (int offset = 0; offset < numSamples;)
+    {
+        const auto numToProcess = juce::jmin (numSamples - offset, subBlockLength - subBlockPosition);
+
+        for (int g = 0; g < numGroups; ++g)
+        {
+            // Both biquads in transposed direct form II, one channel per lane
+            auto& group = groups[(size_t) g];
+            auto s = group.state;
+            auto sumSquares = group.sumSquares;
+
+            const int firstChannel = g * lanes;
+            const int numLanes = juce::jlimit (0, lanes, numInputChannels - firstChannel);
+
+            for (int tileOffset = 0; tileOffset < numToProcess; tileOffset += tileLength)
+            {
+                const int length = juce::jmin (tileLength, numToProcess - tileOffset);
+
+                // Transpose the group's channels into the tile, one channel at a time
+                for (int lane = 0; lane < lanes; ++lane)
+                {
+                    if (lane < numLanes)
+                    {
+                        const auto* input = channels[firstChannel + lane] + offset + tileOffset;
+
+                        for (int i = 0; i < length; ++i)
+                            tileValues[i * lanes + lane] = (double) input[i];
+                    }
+                    else
+                    {
+                        for (int i = 0; i < length; ++i)
+                            tileValues[i * lanes + lane] = 0.0;
+                    }
+                }
+
+                for (int i = 0; i < length; ++i)
+                {
+                    const auto x = tile[(size_t) i];
+
+                    const auto shelved = shelfB0 * x + s[0];
+                    s[0] = shelfB1 * x - shelfA1 * shelved + s[1];
+                    s[1] = shelfB2 * x - shelfA2 * shelved;
+
+                    const auto weighted = shelved + s[2];
+                    s[2] = minusTwo * shelved - passA1 * weighted + s[3];
+                    s[3] = shelved - passA2 * weighted;
+
+                    sumSquares = Vec::multiplyAdd (sumSquares, weighted, weighted);
+                }
+            }
+
+            group.state = s;
+            group.sumSquares = sumSquares;
+        }
+
+        offset += numToProcess;
+        subBlockPosition += numToProcess;
+
+        if (subBlockPosition == subBlockLength)
+            finishSubBlock();
+    }
+}
+
+template void LoudnessMeter::process<float>  (const float* const*, int, int) noexcept;
+template void LoudnessMeter::process<double> (const double* const*, int, int) noexcept;
+
+void LoudnessMeter::finishSubBlock() noexcept
+{
+    double power = 0.0;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        power += weights[(size_t) ch] * groups[(size_t) (ch / lanes)].sumSquares.get ((size_t) (ch % lanes)) / subBlockLength;
+
+    for (auto& group : groups)
+        group.sumSquares = Vec::expand (0.0);
+
+    subBlockPosition = 0;
+    subBlockPowers[(size_t) subBlockIndex] = power;
+    subBlockIndex = (subBlockIndex + 1) % shortTermSubBlocks;
+    numSubBlocks = juce::jmin (numSubBlocks + 1, shortTermSubBlocks);
+
+    // Each window is the mean power of the sub-blocks it spans
+    double momentaryPower = 0.0, shortTermPower = 0.0;
+
+    for (int i = 0; i < shortTermSubBlocks; ++i)
+    {
+        const auto subBlockPower = subBlockPowers[(size_t) ((subBlockIndex + shortTermSubBlocks - 1 - i) % shortTermSubBlocks)];
+        shortTermPower += subBlockPower;
+
+        if (i < momentarySubBlocks)
+            momentaryPower += subBlockPower;
+    }
+
+    momentaryPower /= momentarySubBlocks;
+    shortTermPower /= shortTermSubBlocks;
+
+    momentaryLoudness = (float) juce::jmax ((double) minLoudness, powerToLoudness (momentaryPower));
+    shortTermLoudness = (float) juce::jmax ((double) minLoudness, powerToLoudness (shortTermPower));
+
+    // Gating blocks overlap by 75% (R128) and short-term values are taken at 10 Hz (Tech 3342);
+    // both only count once their window has been completely filled
+    if (numSubBlocks >= momentarySubBlocks)
+        addToHistogram (momentaryHistogram, momentaryPower);
+
+    if (numSubBlocks >= shortTermSubBlocks)
+        addToHistogram (shortTermHistogram, shortTermPower);
+
+    histogramVersion.fetch_add (1, std::memory_order_release);
+}
+
+void LoudnessMeter::addToHistogram (Histogram& histogram, double power) noexcept
+{
+    const auto loudness = powerToLoudness (power);
+
+    // Absolute gate
+    if (loudness <= histogramMinLoudness)
+        return;
+
+    const auto bin = juce::jmin (numHistogramBins - 1, (int) ((loudness - histogramMinLoudness) / histogramBinWidth));
+    histogram[(size_t) bin].fetch_add (1, std::memory_order_relaxed);
+}
+
+double LoudnessMeter::getBinPower (int bin) noexcept
+{
+    static const auto powers = []
+    {
+        std::array<double, numHistogramBins> table {};
+
+        for (int i = 0; i < numHistogramBins; ++i)
+            table[(size_t) i] = std::pow (10.0, (histogramMinLoudness + (i + 0.5) * histogramBinWidth + 0.691) / 10.0);
+
+        return table;
+    }();
+
+    return powers[(size_t) bin];
+}
+
+//==============================================================================
+namespace
+{
+    template <typename HistogramType>
+    auto loadCounts (const HistogramType& histogram) noexcept
+    {
+        std::array<juce::uint32, std::tuple_size<HistogramType>::value> counts;
+
+        for (size_t i = 0; i < counts.size(); ++i)
+            counts[i] = histogram[i].load (std::memory_order_relaxed);
+
+        return counts;
+    }
+}
+
+float LoudnessMeter::getIntegratedLoudness() const noexcept
+{
+    const auto counts = loadCounts (momentaryHistogram);
+
+    // Mean power of the blocks from firstBin up, or 0 if there are none
+    auto getGatedPower = [&counts] (int firstBin)
+    {
+        double sum = 0.0;
+        juce::uint64 numBlocks = 0;
+
+        for (int bin = juce::jmax (0, firstBin); bin < numHistogramBins; ++bin)
+        {
+            sum += counts[(size_t) bin] * getBinPower (bin);
+            numBlocks += counts[(size_t) bin];
+        }
+
+        return numBlocks > 0 ? sum / (double) numBlocks : 0.0;
+    };
+
+    const auto absoluteGatedPower = getGatedPower (0);
+
+    if (absoluteGatedPower <= 0.0)
+        return minLoudness;
+
+    // Relative gate: 10 LU below the absolute-gated loudness; a bin counts if its centre is above it
+    const auto relativeGate = powerToLoudness (absoluteGatedPower) - 10.0;
+    const auto firstBin = (int) std::floor ((relativeGate - histogramMinLoudness) / histogramBinWidth - 0.5) + 1;
+
+    return (float) powerToLoudness (getGatedPower (firstBin));
+}
+
+float LoudnessMeter::getLoudnessRange() const noexcept
+{
+    const auto counts = loadCounts (shortTermHistogram);
+
+    double sum = 0.0;
+    juce::uint64 numValues = 0;
+
+    for (int bin = 0; bin < numHistogramBins; ++bin)
+    {
+        sum += counts[(size_t) bin] * getBinPower (bin);
+        numValues += counts[(size_t) bin];
+    }
+
+    if (numValues == 0)
+        return 0.0f;
+
+    // Tech 3342: relative gate 20 LU below, then the spread between the 10th and 95th percentiles
+    const auto relativeGate = powerToLoudness (sum / (double) numValues) - 20.0;
+    const auto firstBin = juce::jmax (0, (int) std::floor ((relativeGate - histogramMinLoudness) / histogramBinWidth - 0.5) + 1);
+
+    juce::uint64 numGated = 0;
+
+    for (int bin = firstBin; bin < numHistogramBins; ++bin)
+        numGated += counts[(size_t) bin];
+
+    if (numGated == 0)
+        return 0.0f;
+
+    auto findPercentileBin = [&] (double percentile)
+    {
+        const auto rank = (juce::uint64) (percentile * (double) (numGated - 1));
+        juce::uint64 cumulative = 0;
+
+        for (int bin = firstBin; bin < numHistogramBins; ++bin)
+        {
+            cumulative += counts[(size_t) bin];
+
+            if (cumulative > rank)
+                return bin;
+        }
+
+        return numHistogramBins - 1;
+    };
+
+    return (float) ((findPercentileBin (0.95) - findPercentileBin (0.10)) * histogramBinWidth);
+}
+
+//==============================================================================
+void LoudnessMeter::saveIntegration (juce::MemoryBlock& destData) const
+{
+    juce::MemoryOutputStream out (destData, false);
+
+    out.writeInt (stateMagic);
+    out.writeInt (stateVersion);
+    out.writeInt (numHistogramBins);
+
+    for (auto count : loadCounts (momentaryHistogram))
+        out.writeInt ((int) count);
+
+    for (auto count : loadCounts (shortTermHistogram))
+        out.writeInt ((int) count);
+}
+
+bool LoudnessMeter::restoreIntegration (const void* data, size_t numBytes)
+{
+    juce::MemoryInputStream in (data, numBytes, false);
+
+    if (in.readInt() != stateMagic || in.readInt() != stateVersion || in.readInt() != numHistogramBins
+         || in.getNumBytesRemaining() < (juce::int64) (2 * numHistogramBins * sizeof (juce::uint32)))
+        return false;
+
+    for (auto& count : momentaryHistogram)
+        count.store ((juce::uint32) in.readInt(), std::memory_order_relaxed);
+
+    for (auto& count : shortTermHistogram)
+        count.store ((juce::uint32) in.readInt(), std::memory_order_relaxed);
+
+    histogramVersion.fetch_add (1, std::memory_order_release);
+    return true;
+}
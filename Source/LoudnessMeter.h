@@ -0,0 +1,128 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+/**
+    Loudness after ITU-R BS.1770-4 and EBU R128 / Tech 3342: momentary (400 ms),
+    short-term (3 s), gated integrated loudness and loudness range.
+
+    process() runs on the audio thread. It K-weights the input and sums its
+    power over 100 ms sub-blocks. Every sub-block closes a 400 ms and a 3 s
+    window, and their loudness goes into one of two fixed histograms of 0.1 LU
+    bins. Gating works on those histograms, so memory and per-block time stay
+    the same however long the measurement runs. The gated values are
+    accurate to within half a bin.
+
+    Channels are weighted as BS.1770 prescribes for their position, and are
+    filtered in SIMD lanes (in double, which the 38 Hz high-pass needs), so a
+    7.1.4 input takes a handful of passes rather than twelve. Each group of
+    channels is transposed a tile at a time, so a whole register is loaded per
+    sample.
+
+    The histogram counts are atomics, so integrated loudness, loudness range,
+    the saved state and resetIntegration() can be used from any thread.
+*/
+class LoudnessMeter
+{
+public:
+    static constexpr int maxChannels = 12; // 7.1.4
+
+    /** Reported for silence and for anything below the absolute gate. */
+    static constexpr float minLoudness = -100.0f;
+
+    LoudnessMeter() = default;
+
+    /** Computes the K-weighting filters and sub-block length for this rate. There
+        is one channel per weight (see ChannelLayoutInfo::getLoudnessWeight).
+    */
+    void prepare (double sampleRate, const std::vector<float>& channelWeights);
+
+    /** Clears the filters and the sliding windows; the integration continues. */
+    void reset() noexcept;
+
+    /** Starts a new integrated/LRA measurement. */
+    void resetIntegration() noexcept;
+
+    //==============================================================================
+    /** Audio thread. Channels beyond those prepared are ignored, missing ones are silent.
+        SampleType is float or double; either is filtered in double.
+    */
+    template <typename SampleType>
+    void process (const SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** Audio thread: the windows as of the last completed sub-block, in LUFS. */
+    float getMomentaryLoudness() const noexcept         { return momentaryLoudness; }
+    float getShortTermLoudness() const noexcept         { return shortTermLoudness; }
+
+    //==============================================================================
+    /** Changes every time a sub-block completes or the integration is reset. */
+    juce::uint32 getHistogramVersion() const noexcept   { return histogramVersion.load (std::memory_order_acquire); }
+
+    float getIntegratedLoudness() const noexcept;
+    float getLoudnessRange() const noexcept;
+
+    /** The integration state (both histograms), for saving with a session. */
+    void saveIntegration (juce::MemoryBlock& destData) const;
+    bool restoreIntegration (const void* data, size_t numBytes);
+
+private:
+    //==============================================================================
+    struct Biquad
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    // 0.1 LU from the absolute gate (-70 LUFS) up to +30 LUFS
+    static constexpr int numHistogramBins = 1000;
+    static constexpr double histogramMinLoudness = -70.0;
+    static constexpr double histogramBinWidth = 0.1;
+
+    using Histogram = std::array<std::atomic<juce::uint32>, numHistogramBins>;
+
+    static constexpr int momentarySubBlocks = 4;  // 400 ms
+    static constexpr int shortTermSubBlocks = 30; // 3 s
+
+    Biquad highShelf, highPass;
+
+    using Vec = juce::dsp::SIMDRegister<double>;
+    static constexpr int lanes = (int) Vec::size();
+
+    // Both biquads' state and the sub-block's sum of squares, one lane per channel
+    struct ChannelGroup
+    {
+        std::array<Vec, 4> state;
+        Vec sumSquares;
+    };
+
+    std::array<ChannelGroup, (maxChannels + lanes - 1) / lanes> groups;
+
+    // tileLength samples of one group, each sample one register
+    static constexpr int tileLength = 64;
+    std::array<Vec, tileLength> tile;
+    std::array<double, maxChannels> weights {};
+    int numChannels = 0, numGroups = 0;
+
+    int subBlockLength = 4800;
+    int subBlockPosition = 0;
+
+    // Powers of the last 30 sub-blocks
+    std::array<double, shortTermSubBlocks> subBlockPowers {};
+    int subBlockIndex = 0;
+    int numSubBlocks = 0;
+
+    float momentaryLoudness = minLoudness;
+    float shortTermLoudness = minLoudness;
+
+    Histogram momentaryHistogram {}, shortTermHistogram {};
+    std::atomic<juce::uint32> histogramVersion { 0 };
+
+    void finishSubBlock() noexcept;
+    static void addToHistogram (Histogram&, double power) noexcept;
+    static double getBinPower (int bin) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoudnessMeter)
+};
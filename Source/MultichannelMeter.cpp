@@ -0,0 +1,100 @@
+#include "MultichannelMeter.h"
+
+void MultichannelMeter::prepare (int numChannels, const std::vector<ChannelLayoutInfo::ChannelPair>& pairs)
+{
+    numPreparedChannels = juce::jlimit (0, maxChannels, numChannels);
+    numPairs = 0;
+
+    for (const auto& pair : pairs)
+        if (numPairs < maxPairs && juce::isPositiveAndBelow (pair.first, numPreparedChannels)
+                                && juce::isPositiveAndBelow (pair.second, numPreparedChannels))
+            pairChannels[(size_t) numPairs++] = pair;
+
+    numChannelGroups = (numPreparedChannels + lanes - 1) / lanes;
+    numPairGroups = (numPairs + lanes - 1) / lanes;
+    vectorsPerSample = numChannelGroups + 2 * numPairGroups;
+
+    tile.assign ((size_t) (tileLength * vectorsPerSample), Vec::expand (0.0f));
+}
+
+template <typename SampleType>
+void MultichannelMeter::process (const SampleType* const* channels, int numChannels, int numSamples,
+                                 MultichannelMeterStats& stats) noexcept
+{
+    numChannels = juce::jmin (numChannels, numPreparedChannels);
+
+    auto* tileValues = reinterpret_cast<float*> (tile.data());
+    const int stride = vectorsPerSample * lanes;
+    const int firstSidesOffset  = numChannelGroups * lanes;
+    const int secondSidesOffset = firstSidesOffset + numPairGroups * lanes;
+
+    std::array<Vec, (maxChannels + lanes - 1) / lanes> peaks;
+    peaks.fill (Vec::expand (0.0f));
+
+    for (int offset = 0; offset < numSamples; offset += tileLength)
+    {
+        const int length = juce::jmin (tileLength, numSamples - offset);
+
+        // Transpose: each channel is read front to back and scattered into its lane
+        auto transpose = [&] (int channel, int lane)
+        {
+            if (channel < numChannels)
+            {
+                const auto* input = channels[channel] + offset;
+
+                for (int i = 0; i < length; ++i)
+                    tileValues[i * stride + lane] = (float) input[i];
+            }
+            else
+            {
+                for (int i = 0; i < length; ++i)
+                    tileValues[i * stride + lane] = 0.0f;
+            }
+        };
+
+        for (int ch = 0; ch < numPreparedChannels; ++ch)
+            transpose (ch, ch);
+
+        for (int pair = 0; pair < numPairs; ++pair)
+        {
+            transpose (pairChannels[(size_t) pair].first,  firstSidesOffset  + pair);
+            transpose (pairChannels[(size_t) pair].second, secondSidesOffset + pair);
+        }
+
+        // Then every register holds one sample of up to `lanes` channels
+        std::array<Vec, (maxChannels + lanes - 1) / lanes> sumSquares;
+        std::array<Vec, (maxPairs + lanes - 1) / lanes> sumCross;
+        sumSquares.fill (Vec::expand (0.0f));
+        sumCross.fill (Vec::expand (0.0f));
+
+        for (int i = 0; i < length; ++i)
+        {
+            const auto* sample = tile.data() + i * vectorsPerSample;
+
+            for (int group = 0; group < numChannelGroups; ++group)
+            {
+                const auto x = sample[group];
+                sumSquares[(size_t) group] = Vec::multiplyAdd (sumSquares[(size_t) group], x, x);
+                peaks[(size_t) group] = Vec::max (peaks[(size_t) group], Vec::abs (x));
+            }
+
+            const auto* firstSides  = sample + numChannelGroups;
+            const auto* secondSides = firstSides + numPairGroups;
+
+            for (int group = 0; group < numPairGroups; ++group)
+                sumCross[(size_t) group] = Vec::multiplyAdd (sumCross[(size_t) group], firstSides[group], secondSides[group]);
+        }
+
+        for (int ch = 0; ch < numPreparedChannels; ++ch)
+            stats.sumSquares[(size_t) ch] += (double) sumSquares[(size_t) (ch / lanes)].get ((size_t) (ch % lanes));
+
+        for (int pair = 0; pair < numPairs; ++pair)
+            stats.sumCross[(size_t) pair] += (double) sumCross[(size_t) (pair / lanes)].get ((size_t) (pair % lanes));
+    }
+
+    for (int ch = 0; ch < numPreparedChannels; ++ch)
+        stats.peaks[(size_t) ch] = juce::jmax (stats.peaks[(size_t) ch], peaks[(size_t) (ch / lanes)].get ((size_t) (ch % lanes)));
+}
+
+template void MultichannelMeter::process<float>  (const float* const*, int, int, MultichannelMeterStats&) noexcept;
+template void MultichannelMeter::process<double> (const double* const*, int, int, MultichannelMeterStats&) noexcept;
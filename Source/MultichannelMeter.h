@@ -0,0 +1,70 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "ChannelLayoutInfo.h"
+#include <array>
+#include <vector>
+
+//==============================================================================
+/** Running sums for one metered block of up to MultichannelMeter::maxChannels channels. */
+struct MultichannelMeterStats
+{
+    static constexpr int maxChannels = 12;
+    static constexpr int maxPairs = 6;
+
+    std::array<double, maxChannels> sumSquares {};
+    std::array<float, maxChannels> peaks {};
+    std::array<double, maxPairs> sumCross {};
+};
+
+//==============================================================================
+/**
+    Per-channel sum of squares and abs peak, plus the cross-sums of chosen
+    channel pairs, for layouts up to 7.1.4.
+
+    The channels run in SIMD lanes rather than one after another: a short run
+    of samples is first transposed into a tile holding each sample of every
+    channel side by side, then one pass over the tile updates all channels
+    with a register per four channels. The pairs' two sides get lanes of their
+    own, so their products need no shuffling either. Twelve channels cost three
+    registers per sample, not twelve scalar loops.
+
+    Like StereoMeterKernel, lanes accumulate in float and are added to the
+    double totals after every tile.
+*/
+class MultichannelMeter
+{
+public:
+    static constexpr int maxChannels = MultichannelMeterStats::maxChannels;
+    static constexpr int maxPairs = MultichannelMeterStats::maxPairs;
+
+    MultichannelMeter() = default;
+
+    /** Allocates the tile; pairs beyond maxPairs are ignored. Not realtime safe. */
+    void prepare (int numChannels, const std::vector<ChannelLayoutInfo::ChannelPair>& pairs);
+
+    /** Adds one block to stats. Channels beyond what prepare() was given are ignored,
+        and missing ones read as silence. Double input is narrowed to float as it
+        is transposed, so the tile pass is the same for both.
+    */
+    template <typename SampleType>
+    void process (const SampleType* const* channels, int numChannels, int numSamples, MultichannelMeterStats& stats) noexcept;
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = (int) Vec::size();
+    static constexpr int tileLength = 128;
+
+    int numPreparedChannels = 0;
+    int numChannelGroups = 0, numPairGroups = 0;
+    int vectorsPerSample = 0;
+
+    int numPairs = 0;
+    std::array<ChannelLayoutInfo::ChannelPair, maxPairs> pairChannels {};
+
+    // tileLength samples, each vectorsPerSample registers: the channels, then the
+    // pairs' first sides, then their second sides. Unused lanes stay zero.
+    std::vector<Vec> tile;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultichannelMeter)
+};
@@ -6,40 +6,238 @@
 AnimeAnalyzerAudioProcessorEditor::AnimeAnalyzerAudioProcessorEditor (AnimeAnalyzerAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
+    using View = AnimeAnalyzerAudioProcessor::SpectrumView;
+
+    viewSelector.addItem ("MID",   (int) View::mid + 1);
+    viewSelector.addItem ("LEFT",  (int) View::left + 1);
+    viewSelector.addItem ("RIGHT", (int) View::right + 1);
+    viewSelector.addItem ("SIDE",  (int) View::side + 1);
+    viewSelector.setSelectedId ((int) currentView + 1, juce::dontSendNotification);
+    viewSelector.onChange = [this] { currentView = (View) (viewSelector.getSelectedId() - 1); };
+    addAndMakeVisible (viewSelector);
+
+    displaySelector.addItem ("BARS", (int) DisplayMode::bars);
+    displaySelector.addItem ("SPECTROGRAM", (int) DisplayMode::spectrogram);
+    displaySelector.addItem ("GONIOMETER", (int) DisplayMode::goniometer);
+    displaySelector.setSelectedId ((int) displayMode, juce::dontSendNotification);
+    displaySelector.onChange = [this] { setDisplayMode ((DisplayMode) displaySelector.getSelectedId()); };
+    addAndMakeVisible (displaySelector);
+
+    // Level (0..255) to colour: black through violet and pink to amber and white
+    juce::ColourGradient gradient (juce::Colours::black, 0.0f, 0.0f, juce::Colours::white, 1.0f, 0.0f, false);
+    gradient.addColour (0.35, juce::Colour (0xff4b0f6b));
+    gradient.addColour (0.60, juce::Colour (0xffe0306f));
+    gradient.addColour (0.85, juce::Colour (0xffffc14d));
+
+    for (size_t i = 0; i < spectrogramColours.size(); ++i)
+    {
+        spectrogramColours[i] = gradient.getColourAtPosition ((double) i / 255.0);
+        goniometerPixels[i] = spectrogramColours[i].getPixelARGB();
+    }
+
+    goniometerIntensity.assign ((size_t) (goniometerSize * goniometerSize), 0.0f);
+    goniometerLevels.assign (goniometerIntensity.size(), 0.0f);
+    goniometerImage = juce::Image (juce::Image::ARGB, goniometerSize, goniometerSize, true, juce::SoftwareImageType());
+
+    setOpaque (true);
     setSize (900, 500);
-    loadDemonGif();
-    startTimerHz (30);
 }
 
 AnimeAnalyzerAudioProcessorEditor::~AnimeAnalyzerAudioProcessorEditor()
 {
-    stopTimer();
+    atlasPool.removeAllJobs (true, 2000);
+}
+
+void AnimeAnalyzerAudioProcessorEditor::setGifAtlasMemoryBudget (size_t numBytes)
+{
+    gifAtlasMemoryBudget = numBytes;
+    gifDecodeQueued = false; // decoded again to the new budget
+    requestedAtlasFrameSize = {};
+    repaint (spectrumArea);
+}
+
+void AnimeAnalyzerAudioProcessorEditor::setDisplayMode (DisplayMode newMode)
+{
+    displayMode = newMode;
+
+    // The bars weren't tracked while hidden
+    resetPaintedHeights();
+    repaint (spectrumArea);
+}
+
+void AnimeAnalyzerAudioProcessorEditor::setNumBands (int newNumBands)
+{
+    numBands = juce::jlimit (1, maxSpectrumBands, newNumBands);
+    columnWidth = (float) spectrumArea.getWidth() / (float) numBands;
+
+    // The old levels belong to other frequencies, so the bars start again from the floor
+    displayBandLevels.fill (0.0f);
+    displayPeakLevels.fill (0.0f);
+    displayAverageLevels.fill (0.0f);
+    resetPaintedHeights();
+
+    staticLayer = {};
+    repaint (spectrumArea);
+}
+
+void AnimeAnalyzerAudioProcessorEditor::resetPaintedHeights()
+{
+    for (int band = 0; band < numBands; ++band)
+    {
+        paintedBarHeights[(size_t) band]     = getBarHeight (band);
+        paintedPeakHeights[(size_t) band]    = getLevelHeight (displayPeakLevels[(size_t) band]);
+        paintedAverageHeights[(size_t) band] = getLevelHeight (displayAverageLevels[(size_t) band]);
+    }
+}
+
+void AnimeAnalyzerAudioProcessorEditor::setFrameStatsVisible (bool shouldBeVisible)
+{
+    showFrameStats = shouldBeVisible;
+    repaint (getFrameStatsBounds());
+    repaint (getLoadStatsBounds());
+}
+
+void AnimeAnalyzerAudioProcessorEditor::mouseDown (const juce::MouseEvent& e)
+{
+    if (showFrameStats && e.mods.isPopupMenu() && getLoadStatsBounds().contains (e.getPosition()))
+        showLoadStatsMenu();
+}
+
+void AnimeAnalyzerAudioProcessorEditor::mouseDoubleClick (const juce::MouseEvent& e)
+{
+    if (e.y < 40)
+        setFrameStatsVisible (! showFrameStats);
+    else if (spectrumArea.contains (e.getPosition()))
+        audioProcessor.resetSpectrumStatistics();
 }
 
 //==============================================================================
 void AnimeAnalyzerAudioProcessorEditor::paint (juce::Graphics& g)
 {
-    g.fillAll (juce::Colours::black);
+    const auto paintStartTicks = juce::Time::getHighResolutionTicks();
+
+    const juce::ScopeGuard recordPaintTime { [this, paintStartTicks]
+    {
+        frameStats.lastPaintMs = 1000.0 * juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - paintStartTicks);
+        frameStats.averagePaintMs += 0.1 * (frameStats.lastPaintMs - frameStats.averagePaintMs);
+    } };
+
+    // Background, title, grid and labels only change with the size or the display's
+    // scale factor, so they come from a cached image drawn at physical resolution
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (! staticLayer.isValid() || staticLayerScale != scale)
+        rebuildStaticLayer (scale);
+
+    g.drawImageTransformed (staticLayer, juce::AffineTransform::scale (1.0f / staticLayerScale));
+
+    // Frames are pre-scaled to a full-height column at physical resolution; a bar
+    // shows the bottom part of its column, so drawing it is a 1:1 copy
+    const juce::Rectangle<int> atlasFrameSize (juce::roundToInt (std::ceil (columnWidth + 1.0f) * scale),
+                                               juce::roundToInt ((float) spectrumArea.getHeight() * scale));
+
+    if (atlasFrameSize != requestedAtlasFrameSize)
+        requestGifAtlas (atlasFrameSize);
+
+    if (displayMode == DisplayMode::spectrogram)
+        paintSpectrogram (g);
+    else if (displayMode == DisplayMode::goniometer)
+        paintGoniometer (g);
+    else
+        paintBars (g);
+
+    if (showFrameStats)
+    {
+        paintFrameStats (g);
+        paintLoadStats (g);
+    }
+}
+
+void AnimeAnalyzerAudioProcessorEditor::paintBars (juce::Graphics& g) const
+{
+    const bool hasAtlas = gifAtlas != nullptr && gifAtlas->getNumFrames() > 0;
+    const auto frameArea = hasAtlas ? gifAtlas->getFrameArea (currentGifFrameIndex) : juce::Rectangle<int>();
+    const auto atlasScale = (float) frameArea.getHeight() / (float) juce::jmax (1, spectrumArea.getHeight());
+
+    // Usually only a few columns are dirty; skip the ones outside the clip
+    const auto clip = g.getClipBounds();
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        const auto barHeight = paintedBarHeights[(size_t) band];
+        const auto column = getColumnBounds (band);
+
+        if (! column.intersects (clip))
+            continue;
+
+        const auto left  = juce::roundToInt ((float) spectrumArea.getX() + (float) band * columnWidth);
+        const auto right = juce::roundToInt ((float) spectrumArea.getX() + (float) (band + 1) * columnWidth);
+
+        if (hasAtlas && barHeight > 0)
+        {
+            const auto sourceWidth  = juce::jmin (frameArea.getWidth(),  juce::roundToInt ((float) (right - left) * atlasScale));
+            const auto sourceHeight = juce::jmin (frameArea.getHeight(), juce::roundToInt ((float) barHeight * atlasScale));
+
+            g.drawImage (gifAtlas->getImage(),
+                         left, spectrumArea.getBottom() - barHeight, right - left, barHeight,
+                         frameArea.getX(), frameArea.getBottom() - sourceHeight, sourceWidth, sourceHeight);
+        }
+
+        // The average goes under the peak, so a held peak is never hidden by it
+        if (const auto averageHeight = paintedAverageHeights[(size_t) band]; averageHeight > 0)
+        {
+            g.setColour (juce::Colour (0xcc4fd6ff));
+            g.fillRect (left, spectrumArea.getBottom() - averageHeight - markerThickness / 2, right - left, markerThickness);
+        }
+
+        if (const auto peakHeight = paintedPeakHeights[(size_t) band]; peakHeight > 0)
+        {
+            g.setColour (juce::Colours::white);
+            g.fillRect (left, spectrumArea.getBottom() - peakHeight - markerThickness / 2, right - left, markerThickness);
+        }
+    }
+}
+
+void AnimeAnalyzerAudioProcessorEditor::resized()
+{
+    auto header = getLocalBounds().removeFromTop (40);
+    viewSelector.setBounds (header.removeFromRight (120).reduced (8));
+    displaySelector.setBounds (header.removeFromRight (150).reduced (8));
 
     auto bounds = getLocalBounds();
+    bounds.removeFromTop (40);
+    spectrumArea = bounds.reduced (40, 20);
+    columnWidth  = (float) spectrumArea.getWidth() / (float) numBands;
+
+    staticLayer = {};
+    resetPaintedHeights();
+}
+
+void AnimeAnalyzerAudioProcessorEditor::rebuildStaticLayer (float scale)
+{
+    staticLayerScale = scale;
+    staticLayer = juce::Image (juce::Image::RGB,
+                               juce::jmax (1, juce::roundToInt ((float) getWidth()  * scale)),
+                               juce::jmax (1, juce::roundToInt ((float) getHeight() * scale)),
+                               false);
+
+    juce::Graphics g (staticLayer);
+    g.addTransform (juce::AffineTransform::scale (scale));
+
+    g.fillAll (juce::Colours::black);
 
     g.setColour (juce::Colours::white);
     g.setFont (juce::Font (24.0f, juce::Font::bold));
-    auto titleArea = bounds.removeFromTop (40);
-    g.drawText ("ANIME-ANALYZER", titleArea,
+    g.drawText ("ANIME-ANALYZER", getLocalBounds().removeFromTop (40),
                 juce::Justification::centred, false);
 
-    auto spectrumArea = bounds.reduced (40, 20);
-
     const float spectrumWidth  = (float) spectrumArea.getWidth();
     const float spectrumHeight = (float) spectrumArea.getHeight();
-
-    const float columnWidth  = spectrumWidth  / (float) numSpectrumBands;
-    const float cellHeight   = spectrumHeight / (float) numSpectrumCells;
+    const float cellHeight     = spectrumHeight / (float) numSpectrumCells;
 
     // Vertical grid lines (one per band)
     g.setColour (juce::Colours::white.withAlpha (0.25f));
-    for (int band = 0; band <= numSpectrumBands; ++band)
+    for (int band = 0; band <= numBands; ++band)
     {
         const float x = spectrumArea.getX() + band * columnWidth;
         g.drawLine (x, (float) spectrumArea.getY(),
@@ -78,102 +276,516 @@ void AnimeAnalyzerAudioProcessorEditor::paint (juce::Graphics& g)
     drawFreqLabel (10000.0f,"10k");
     drawFreqLabel (20000.0f,"20k");
 
-    juce::Image frame;
-    if (! gifFrames.isEmpty())
-        frame = gifFrames[currentGifFrameIndex];
+    // Darkened column backgrounds the bars are drawn over
+    g.setColour (juce::Colours::black.withAlpha (0.85f));
+    for (int band = 0; band < numBands; ++band)
+    {
+        const float x = spectrumArea.getX() + band * columnWidth;
+        g.fillRect (juce::Rectangle<float> (x, (float) spectrumArea.getY(), columnWidth, spectrumHeight));
+    }
+}
+
+juce::Rectangle<int> AnimeAnalyzerAudioProcessorEditor::getColumnBounds (int band) const
+{
+    const float x = (float) spectrumArea.getX() + (float) band * columnWidth;
+
+    return juce::Rectangle<float> (x, (float) spectrumArea.getY(), columnWidth, (float) spectrumArea.getHeight())
+               .getSmallestIntegerContainer();
+}
+
+int AnimeAnalyzerAudioProcessorEditor::getBarHeight (int band) const
+{
+    return getLevelHeight (displayBandLevels[(size_t) band]);
+}
+
+int AnimeAnalyzerAudioProcessorEditor::getLevelHeight (float level) const
+{
+    return juce::roundToInt (juce::jlimit (0.0f, 1.0f, level) * (float) spectrumArea.getHeight());
+}
+
+juce::Rectangle<int> AnimeAnalyzerAudioProcessorEditor::getMarkerBounds (int band, int height) const
+{
+    const auto centre = spectrumArea.getBottom() - height;
+    return getColumnBounds (band).withTop (centre - markerThickness).withHeight (2 * markerThickness);
+}
 
-    for (int band = 0; band < numSpectrumBands; ++band)
+//==============================================================================
+void AnimeAnalyzerAudioProcessorEditor::onVBlank (double timestampSeconds)
+{
+    if (lastVBlankTime > 0.0)
     {
-        const float level = juce::jlimit (0.0f, 1.0f, displayBandLevels[(size_t) band]);
-        const float barHeight = level * spectrumHeight;
+        // A vblank interval well above the usual one means the message thread missed frames
+        const auto intervalMs = 1000.0 * (timestampSeconds - lastVBlankTime);
 
-        const float x = spectrumArea.getX() + band * columnWidth;
-        const float y = spectrumArea.getBottom() - barHeight;
+        if (frameStats.vblankIntervalMs <= 0.0 || intervalMs < 1.5 * frameStats.vblankIntervalMs)
+            frameStats.vblankIntervalMs += 0.1 * (intervalMs - frameStats.vblankIntervalMs);
+        else
+            frameStats.droppedFrames += juce::roundToInt (intervalMs / frameStats.vblankIntervalMs) - 1;
+    }
 
-        juce::Rectangle<float> columnBounds (x, (float) spectrumArea.getY(), columnWidth, spectrumHeight);
-        juce::Rectangle<float> barBounds (x, y, columnWidth, barHeight);
+    lastVBlankTime = timestampSeconds;
 
-        g.setColour (juce::Colours::black.withAlpha (0.85f));
-        g.fillRect (columnBounds);
+    if (lastUpdateTime <= 0.0)
+    {
+        lastUpdateTime = timestampSeconds;
+        return;
+    }
 
-        if (barHeight > 0.0f && frame.isValid())
-        {
-            g.drawImage (frame,
-                         barBounds,
-                         juce::RectanglePlacement::stretchToFit);
-        }
+    // Half a vblank of slack, so a 60 Hz display doesn't skip every other 1/60 s update
+    const auto elapsed = timestampSeconds - lastUpdateTime;
+
+    if (elapsed < getTargetFrameInterval() - 0.0005 * frameStats.vblankIntervalMs)
+        return;
+
+    lastUpdateTime = timestampSeconds;
+    frameStats.averageFrameIntervalMs += 0.1 * (1000.0 * elapsed - frameStats.averageFrameIntervalMs);
+
+    // After a stall (or while hidden) catch up in one bounded step rather than fast-forwarding
+    const auto deltaSeconds = juce::jmin (elapsed, maxFrameDelta);
+
+    updateFromProcessor (deltaSeconds);
+    const bool gifFrameChanged = advanceGifAnimation (deltaSeconds);
+    const bool spectrogramChanged = drainSpectrogram();
+    const bool goniometerChanged = drainGoniometer (deltaSeconds);
+    bool levelsChanged = false;
+
+    if (displayMode == DisplayMode::spectrogram)
+    {
+        if (spectrogramChanged)
+            repaint (spectrumArea);
+
+        levelsChanged = spectrogramChanged;
+    }
+    else if (displayMode == DisplayMode::goniometer)
+    {
+        if (goniometerChanged)
+            repaint (getGoniometerBounds());
+
+        levelsChanged = goniometerChanged;
+    }
+    else
+    {
+        levelsChanged = repaintChangedColumns (gifFrameChanged);
+    }
+
+    secondsSinceLevelsChanged = levelsChanged ? 0.0 : secondsSinceLevelsChanged + deltaSeconds;
+
+    if (showFrameStats)
+    {
+        repaint (getFrameStatsBounds());
+        repaint (getLoadStatsBounds());
     }
 }
 
-void AnimeAnalyzerAudioProcessorEditor::resized()
+double AnimeAnalyzerAudioProcessorEditor::getTargetFrameInterval() const
 {
+    if (isOccluded())
+        return hiddenFrameInterval;
+
+    auto interval = secondsSinceLevelsChanged >= idleAfterSeconds ? idleFrameInterval
+                                                                  : activeFrameInterval;
+
+    if (gifAtlas != nullptr && gifAtlas->getNumFrames() > 1)
+    {
+        const auto untilNextGifFrame = gifAtlas->getFrameDuration (currentGifFrameIndex) - gifTimeAccumulatorSeconds;
+        interval = juce::jlimit (activeFrameInterval, interval, untilNextGifFrame);
+    }
+
+    return interval;
 }
 
-//==============================================================================
-void AnimeAnalyzerAudioProcessorEditor::timerCallback()
+bool AnimeAnalyzerAudioProcessorEditor::isOccluded() const
 {
-    updateFromProcessor();
-    advanceGifAnimation (1.0 / 30.0);
-    repaint();
+    if (! isShowing())
+        return true;
+
+    auto* peer = getPeer();
+    return peer == nullptr || peer->isMinimised();
 }
 
-void AnimeAnalyzerAudioProcessorEditor::updateFromProcessor()
+bool AnimeAnalyzerAudioProcessorEditor::repaintChangedColumns (bool gifFrameChanged)
 {
-    for (int i = 0; i < numSpectrumBands; ++i)
+    bool anyHeightChanged = false;
+
+    for (int band = 0; band < numBands; ++band)
     {
-        const float target = audioProcessor.getSpectrumBandLevel (i);
+        // A marker that moves only needs its old and new position redrawn
+        auto repaintMarker = [this, band, &anyHeightChanged] (float level, int& paintedHeight)
+        {
+            const auto newHeight = getLevelHeight (level);
+
+            if (newHeight == paintedHeight)
+                return;
+
+            repaint (getMarkerBounds (band, paintedHeight));
+            repaint (getMarkerBounds (band, newHeight));
+            paintedHeight = newHeight;
+            anyHeightChanged = true;
+        };
+
+        repaintMarker (displayPeakLevels[(size_t) band], paintedPeakHeights[(size_t) band]);
+        repaintMarker (displayAverageLevels[(size_t) band], paintedAverageHeights[(size_t) band]);
+
+        const auto newHeight = getBarHeight (band);
+        const auto oldHeight = paintedBarHeights[(size_t) band];
+
+        if (newHeight == oldHeight && ! (gifFrameChanged && newHeight > 0))
+            continue;
+
+        // The frame is fixed to the column and the bar only reveals it, so a height
+        // change touches the strip between the two heights; a new frame the whole bar
+        const auto column = getColumnBounds (band);
+        const auto top    = spectrumArea.getBottom() - juce::jmax (newHeight, oldHeight);
+        const auto bottom = gifFrameChanged ? spectrumArea.getBottom()
+                                            : spectrumArea.getBottom() - juce::jmin (newHeight, oldHeight);
+
+        repaint (column.withTop (top).withBottom (bottom + 1));
+
+        anyHeightChanged = anyHeightChanged || newHeight != oldHeight;
+        paintedBarHeights[(size_t) band] = newHeight;
+    }
+
+    return anyHeightChanged;
+}
+
+void AnimeAnalyzerAudioProcessorEditor::updateFromProcessor (double deltaSeconds)
+{
+    const float decay = std::pow (meterDecay, (float) (deltaSeconds * 30.0));
+
+    const auto& frame = audioProcessor.getLatestAnalysisFrame();
+
+    if (frame.numSpectrumBands != numBands)
+        setNumBands (frame.numSpectrumBands);
+
+    for (int i = 0; i < numBands; ++i)
+    {
+        const float target = frame.getSpectrumBandLevel (i, currentView);
         const float current = displayBandLevels[(size_t) i];
 
         const float smoothed =
             juce::jlimit (0.0f, 1.0f,
-                          current * meterDecay + (1.0f - meterDecay) * target);
+                          current * decay + (1.0f - decay) * target);
 
         displayBandLevels[(size_t) i] = smoothed;
+
+        // Already shaped over time by the engine
+        displayPeakLevels[(size_t) i]    = frame.getPeakBandLevel (i, currentView);
+        displayAverageLevels[(size_t) i] = frame.getAverageBandLevel (i, currentView);
     }
 }
 
-void AnimeAnalyzerAudioProcessorEditor::advanceGifAnimation (double deltaSeconds)
+bool AnimeAnalyzerAudioProcessorEditor::advanceGifAnimation (double deltaSeconds)
 {
-    if (gifFrames.isEmpty())
-        return;
+    if (gifAtlas == nullptr || gifAtlas->getNumFrames() < 2)
+        return false;
 
+    // Honour each frame's own delay, skipping frames if updates fell behind
     gifTimeAccumulatorSeconds += deltaSeconds;
-    if (gifTimeAccumulatorSeconds >= gifFrameDurationSeconds)
+    bool frameChanged = false;
+
+    while (gifTimeAccumulatorSeconds >= gifAtlas->getFrameDuration (currentGifFrameIndex))
     {
-        gifTimeAccumulatorSeconds -= gifFrameDurationSeconds;
-        currentGifFrameIndex = (currentGifFrameIndex + 1) % gifFrames.size();
+        gifTimeAccumulatorSeconds -= gifAtlas->getFrameDuration (currentGifFrameIndex);
+        currentGifFrameIndex = (currentGifFrameIndex + 1) % gifAtlas->getNumFrames();
+        frameChanged = true;
     }
+
+    return frameChanged;
 }
 
-void AnimeAnalyzerAudioProcessorEditor::loadDemonGif()
+void AnimeAnalyzerAudioProcessorEditor::requestGifAtlas (juce::Rectangle<int> frameSize)
 {
-    gifFrames.clear();
+    requestedAtlasFrameSize = frameSize;
 
-    auto* data = BinaryData::demon_girl_gif;
-    auto  size = BinaryData::demon_girl_gifSize;
+    if (frameSize.isEmpty())
+        return;
 
-    if (data == nullptr || size <= 0)
+    // Decoded once, in a job of its own, so a newer size never throws the frames away.
+    // The decoded frames are held to the same budget as the atlas.
+    if (! gifDecodeQueued)
     {
-        juce::Image fallback (juce::Image::ARGB, 64, 128, true);
-        juce::Graphics g (fallback);
-        g.fillAll (juce::Colours::red);
-        gifFrames.add (fallback);
+        gifDecodeQueued = true;
+        atlasPool.addJob ([this, budget = gifAtlasMemoryBudget] { decodedGifFrames = decodeDemonGif (budget); });
+    }
+
+    const auto generation = ++gifAtlasGeneration;
+
+    atlasPool.addJob ([this, safeThis = juce::Component::SafePointer<AnimeAnalyzerAudioProcessorEditor> (this),
+                       frameSize, budget = gifAtlasMemoryBudget, generation]
+    {
+        // A newer size was requested while this one was queued
+        if (generation != gifAtlasGeneration.load())
+            return;
+
+        auto atlas = std::make_shared<const GifFrameAtlas> (decodedGifFrames, frameSize.getWidth(),
+                                                            frameSize.getHeight(), budget);
+
+        juce::MessageManager::callAsync ([safeThis, atlas, generation]
+        {
+            auto* editor = safeThis.getComponent();
+
+            if (editor == nullptr || generation != editor->gifAtlasGeneration.load())
+                return;
+
+            editor->gifAtlas = atlas;
+            editor->currentGifFrameIndex %= juce::jmax (1, editor->gifAtlas->getNumFrames());
+            editor->repaint (editor->spectrumArea);
+        });
+    });
+}
+
+//==============================================================================
+bool AnimeAnalyzerAudioProcessorEditor::drainSpectrogram()
+{
+    // Drained even while the bars are showing, so switching over shows recent history
+    auto& spectrogram = audioProcessor.getSpectrogram();
+    const auto numRows = spectrogram.getNumReadableRows();
+
+    // A software image, so its pixels are exactly PixelRGB whatever the platform
+    const auto maxDepth = (int) (maxSpectrogramImageBytes / ((size_t) numRows * sizeof (juce::PixelRGB)));
+    const auto depth = juce::jlimit (minSpectrogramDepth, maxDepth, audioProcessor.getSpectrogramDepth());
+
+    if (! spectrogramImage.isValid() || spectrogramImage.getHeight() != numRows || spectrogramImage.getWidth() != depth)
+    {
+        spectrogramImage = juce::Image (juce::Image::RGB, depth, numRows, true, juce::SoftwareImageType());
+        spectrogramWriteColumn = 0;
+    }
+
+    std::unique_ptr<juce::Image::BitmapData> pixels;
+
+    const auto numColumns = spectrogram.readAll ([&] (const juce::uint8* column, int rows)
+    {
+        if (pixels == nullptr)
+            pixels = std::make_unique<juce::Image::BitmapData> (spectrogramImage, juce::Image::BitmapData::writeOnly);
+
+        // Lowest frequency at the bottom
+        for (int row = 0; row < juce::jmin (rows, pixels->height); ++row)
+            pixels->setPixelColour (spectrogramWriteColumn, pixels->height - 1 - row, spectrogramColours[column[row]]);
+
+        spectrogramWriteColumn = (spectrogramWriteColumn + 1) % pixels->width;
+    });
+
+    return numColumns > 0;
+}
+
+void AnimeAnalyzerAudioProcessorEditor::paintSpectrogram (juce::Graphics& g) const
+{
+    if (! spectrogramImage.isValid())
         return;
+
+    const auto width  = spectrogramImage.getWidth();
+    const auto height = spectrogramImage.getHeight();
+    const auto area = spectrumArea.toFloat();
+    const auto xScale = area.getWidth() / (float) width;
+    const auto yScale = area.getHeight() / (float) height;
+
+    g.setImageResamplingQuality (juce::Graphics::lowResamplingQuality);
+
+    // Oldest columns (from the write position on) to the left, newest to the right
+    const auto numOlder = width - spectrogramWriteColumn;
+
+    g.drawImageTransformed (spectrogramImage.getClippedImage ({ spectrogramWriteColumn, 0, numOlder, height }),
+                            juce::AffineTransform::scale (xScale, yScale).translated (area.getX(), area.getY()));
+
+    if (spectrogramWriteColumn > 0)
+        g.drawImageTransformed (spectrogramImage.getClippedImage ({ 0, 0, spectrogramWriteColumn, height }),
+                                juce::AffineTransform::scale (xScale, yScale).translated (area.getX() + (float) numOlder * xScale, area.getY()));
+}
+
+//==============================================================================
+bool AnimeAnalyzerAudioProcessorEditor::drainGoniometer (double deltaSeconds)
+{
+    auto& goniometer = audioProcessor.getGoniometer();
+
+    // Drained while hidden too, so the points are recent when it's shown again
+    if (displayMode != DisplayMode::goniometer)
+    {
+        goniometer.readAll ([] (const GoniometerBuffer::Point*, int) {});
+        return false;
     }
 
-    juce::MemoryInputStream stream (data, size, false);
-    juce::GIFImageFormat gifFormat;
+    const auto numCells = (int) goniometerIntensity.size();
+    auto* intensity = goniometerIntensity.data();
+    const auto wasVisible = goniometerMaxIntensity >= 1.0f / 255.0f;
+
+    // The whole buffer fades at once, by however much this frame's interval calls for
+    const auto fade = (float) std::exp2 (-deltaSeconds / goniometerHalfLifeSeconds);
+    juce::FloatVectorOperations::multiply (intensity, fade, numCells);
+    goniometerMaxIntensity *= fade;
 
-    if (auto image = gifFormat.decodeImage (stream); image.isValid())
+    // Rotated 45 degrees: mono straight up, out of phase across, full scale at the edge
+    const auto centre = (float) goniometerSize * 0.5f;
+
+    const auto numPoints = goniometer.readAll ([&] (const GoniometerBuffer::Point* points, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            const auto x = (int) (centre + (points[i].right - points[i].left) * 0.5f * centre);
+            const auto y = (int) (centre - (points[i].left + points[i].right) * 0.5f * centre);
+
+            if (juce::isPositiveAndBelow (x, goniometerSize) && juce::isPositiveAndBelow (y, goniometerSize))
+                intensity[y * goniometerSize + x] += goniometerPointIntensity;
+        }
+    });
+
+    if (numPoints > 0)
+        goniometerMaxIntensity = juce::FloatVectorOperations::findMaximum (intensity, numCells);
+    else if (! wasVisible)
+        return false;
+
+    // Intensity to palette index for every cell in bulk; only the lookup is per pixel
+    auto* levels = goniometerLevels.data();
+    juce::FloatVectorOperations::clip (levels, intensity, 0.0f, 1.0f, numCells);
+    juce::FloatVectorOperations::multiply (levels, 255.0f, numCells);
+
+    const juce::Image::BitmapData pixels (goniometerImage, juce::Image::BitmapData::writeOnly);
+
+    for (int y = 0; y < goniometerSize; ++y)
     {
-        gifFrames.add (image);
+        auto* line = reinterpret_cast<juce::PixelARGB*> (pixels.getLinePointer (y));
+        const auto* row = levels + y * goniometerSize;
+
+        for (int x = 0; x < goniometerSize; ++x)
+            line[x] = goniometerPixels[(size_t) row[x]];
     }
 
-    if (gifFrames.isEmpty())
+    return true;
+}
+
+juce::Rectangle<int> AnimeAnalyzerAudioProcessorEditor::getGoniometerBounds() const
+{
+    const auto side = juce::jmin (spectrumArea.getWidth(), spectrumArea.getHeight());
+    return spectrumArea.withSizeKeepingCentre (side, side);
+}
+
+void AnimeAnalyzerAudioProcessorEditor::paintGoniometer (juce::Graphics& g) const
+{
+    const auto area = getGoniometerBounds().toFloat();
+
+    g.setColour (juce::Colours::black);
+    g.fillRect (spectrumArea);
+
+    g.setImageResamplingQuality (juce::Graphics::mediumResamplingQuality);
+    g.drawImage (goniometerImage, area);
+
+    // Mono and side axes, and the left and right channels on the diagonals
+    g.setColour (juce::Colours::white.withAlpha (0.2f));
+    g.drawLine (area.getCentreX(), area.getY(), area.getCentreX(), area.getBottom(), 1.0f);
+    g.drawLine (area.getX(), area.getCentreY(), area.getRight(), area.getCentreY(), 1.0f);
+    g.drawLine ({ area.getTopLeft(), area.getBottomRight() }, 1.0f);
+    g.drawLine ({ area.getTopRight(), area.getBottomLeft() }, 1.0f);
+
+    g.setColour (juce::Colours::white.withAlpha (0.5f));
+    g.setFont (12.0f);
+
+    const auto label = [&] (const char* text, juce::Point<float> position)
+    {
+        g.drawText (text, juce::Rectangle<float> (20.0f, 16.0f).withCentre (position), juce::Justification::centred, false);
+    };
+
+    label ("M", { area.getCentreX() + 10.0f, area.getY() + 10.0f });
+    label ("L", { area.getX() + 14.0f, area.getY() + 10.0f });
+    label ("R", { area.getRight() - 14.0f, area.getY() + 10.0f });
+    label ("S", { area.getRight() - 10.0f, area.getCentreY() - 10.0f });
+}
+
+//==============================================================================
+juce::Rectangle<int> AnimeAnalyzerAudioProcessorEditor::getFrameStatsBounds() const
+{
+    return getLocalBounds().removeFromTop (40).removeFromLeft (260).reduced (6);
+}
+
+void AnimeAnalyzerAudioProcessorEditor::paintFrameStats (juce::Graphics& g) const
+{
+    const auto bounds = getFrameStatsBounds();
+
+    g.setColour (juce::Colours::black.withAlpha (0.7f));
+    g.fillRect (bounds);
+
+    g.setColour (juce::Colours::limegreen);
+    g.setFont (juce::Font (juce::Font::getDefaultMonospacedFontName(), 11.0f, juce::Font::plain));
+
+    g.drawText (juce::String::formatted ("paint %.2f ms (avg %.2f)", frameStats.lastPaintMs, frameStats.averagePaintMs),
+                bounds.withHeight (bounds.getHeight() / 2).reduced (4, 0), juce::Justification::centredLeft, false);
+
+    g.drawText (juce::String::formatted ("frame %.1f ms  dropped %d", frameStats.averageFrameIntervalMs, frameStats.droppedFrames),
+                bounds.withTrimmedTop (bounds.getHeight() / 2).reduced (4, 0), juce::Justification::centredLeft, false);
+}
+
+juce::Rectangle<int> AnimeAnalyzerAudioProcessorEditor::getLoadStatsBounds() const
+{
+    return spectrumArea.withSize (300, 50).reduced (6);
+}
+
+void AnimeAnalyzerAudioProcessorEditor::paintLoadStats (juce::Graphics& g) const
+{
+    const auto bounds = getLoadStatsBounds();
+    const auto& profiler = audioProcessor.getLoadProfiler();
+
+    g.setColour (juce::Colours::black.withAlpha (0.7f));
+    g.fillRect (bounds);
+
+    g.setColour (juce::Colours::limegreen);
+    g.setFont (juce::Font (juce::Font::getDefaultMonospacedFontName(), 11.0f, juce::Font::plain));
+
+    auto lines = bounds.reduced (4, 0);
+    const auto lineHeight = lines.getHeight() / 3;
+
+    g.drawText ("       p50 us  p99 us  max us  p99 load", lines.removeFromTop (lineHeight),
+                juce::Justification::centredLeft, false);
+
+    // Load is the fraction of the real time the block or frame stands for
+    auto drawSection = [&] (const char* name, LoadProfiler::Section section)
     {
-        juce::Image fallback (juce::Image::ARGB, 64, 128, true);
+        const auto summary = profiler.getSummary (section);
+
+        g.drawText (juce::String::formatted ("%-6s %6.1f  %6.1f  %6.1f  %7.1f%%", name, summary.p50Micros,
+                                             summary.p99Micros, summary.maxMicros, summary.p99Load * 100.0),
+                    lines.removeFromTop (lineHeight), juce::Justification::centredLeft, false);
+    };
+
+    drawSection ("block", LoadProfiler::Section::processBlock);
+    drawSection ("fft", LoadProfiler::Section::fftFrame);
+}
+
+void AnimeAnalyzerAudioProcessorEditor::showLoadStatsMenu()
+{
+    juce::PopupMenu menu;
+    menu.addItem ("Export load profile...", [this]
+    {
+        loadProfileChooser = std::make_unique<juce::FileChooser> ("Export load profile",
+                                                                  juce::File::getSpecialLocation (juce::File::userDocumentsDirectory)
+                                                                      .getChildFile ("load-profile.json"),
+                                                                  "*.json");
+
+        loadProfileChooser->launchAsync (juce::FileBrowserComponent::saveMode
+                                             | juce::FileBrowserComponent::canSelectFiles
+                                             | juce::FileBrowserComponent::warnAboutOverwriting,
+                                         [this] (const juce::FileChooser& chooser)
+        {
+            const auto file = chooser.getResult();
+
+            if (file != juce::File() && ! audioProcessor.exportLoadProfile (file))
+                juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon, "Export load profile",
+                                                        "Couldn't write " + file.getFullPathName());
+        });
+    });
+
+    menu.addItem ("Reset load profile", [this] { audioProcessor.resetLoadProfile(); });
+    menu.showMenuAsync (juce::PopupMenu::Options().withTargetComponent (this).withMousePosition());
+}
+
+std::vector<GifDecoder::Frame> AnimeAnalyzerAudioProcessorEditor::decodeDemonGif (size_t memoryBudgetBytes)
+{
+    auto frames = GifDecoder::decode (BinaryData::demon_girl_gif, (size_t) BinaryData::demon_girl_gifSize, memoryBudgetBytes);
+
+    if (frames.empty())
+    {
+        juce::Image fallback (juce::SoftwareImageType().create (juce::Image::ARGB, 64, 128, true));
         juce::Graphics g (fallback);
         g.fillAll (juce::Colours::red);
-        gifFrames.add (fallback);
+        frames.push_back ({ fallback, 0.1 });
     }
+
+    return frames;
 }
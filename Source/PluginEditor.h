@@ -2,10 +2,12 @@
 
 #include "JuceHeader.h"
 #include <array>
+#include <atomic>
+#include <memory>
 #include "PluginProcessor.h"
+#include "GifFrameAtlas.h"
 
-class AnimeAnalyzerAudioProcessorEditor  : public juce::AudioProcessorEditor,
-                                           private juce::Timer
+class AnimeAnalyzerAudioProcessorEditor  : public juce::AudioProcessorEditor
 {
 public:
     explicit AnimeAnalyzerAudioProcessorEditor (AnimeAnalyzerAudioProcessor&);
@@ -13,25 +15,157 @@ public:
 
     void paint (juce::Graphics&) override;
     void resized() override;
+    void mouseDown (const juce::MouseEvent&) override;
+    void mouseDoubleClick (const juce::MouseEvent&) override;
+
+    /** Shows paint time, frame interval and dropped frames in the title bar, and the
+        processBlock / FFT frame timings over the spectrum. Double-clicking the title
+        toggles it too; right-clicking the timings exports or resets them.
+    */
+    void setFrameStatsVisible (bool shouldBeVisible);
+
+    /** Caps the memory used by the decoded GIF frames, and again by their pre-scaled
+        atlas; frames are dropped to fit.
+    */
+    void setGifAtlasMemoryBudget (size_t numBytes);
+
+    static constexpr size_t defaultGifAtlasMemoryBudget = 32 * 1024 * 1024;
+
+    // The processor's spectrogram depth is capped so the history image stays within
+    // maxSpectrogramImageBytes at the current row count; a new depth clears the history
+    static constexpr int minSpectrogramDepth = 64;
+    static constexpr size_t maxSpectrogramImageBytes = 8 * 1024 * 1024;
 
 private:
-    void timerCallback() override;
-    void updateFromProcessor();
-    void advanceGifAnimation (double deltaSeconds);
-    void loadDemonGif();
+    void onVBlank (double timestampSeconds);
+    double getTargetFrameInterval() const;
+    bool isOccluded() const;
+
+    void updateFromProcessor (double deltaSeconds);
+    bool advanceGifAnimation (double deltaSeconds);
+    bool repaintChangedColumns (bool gifFrameChanged);
+    void requestGifAtlas (juce::Rectangle<int> frameSize);
+    static std::vector<GifDecoder::Frame> decodeDemonGif (size_t memoryBudgetBytes);
+
+    enum class DisplayMode
+    {
+        bars = 1,
+        spectrogram,
+        goniometer
+    };
+
+    void setDisplayMode (DisplayMode newMode);
+    void setNumBands (int newNumBands);
+    void resetPaintedHeights();
+    void paintBars (juce::Graphics&) const;
+    bool drainSpectrogram();
+    void paintSpectrogram (juce::Graphics&) const;
+    bool drainGoniometer (double deltaSeconds);
+    void paintGoniometer (juce::Graphics&) const;
+    juce::Rectangle<int> getGoniometerBounds() const;
+
+    void rebuildStaticLayer (float scale);
+    juce::Rectangle<int> getColumnBounds (int band) const;
+    int getBarHeight (int band) const;
+    int getLevelHeight (float level) const;
+    juce::Rectangle<int> getMarkerBounds (int band, int height) const;
 
     AnimeAnalyzerAudioProcessor& audioProcessor;
 
-    static constexpr int numSpectrumBands  = AnimeAnalyzerAudioProcessor::getNumSpectrumBands();
+    static constexpr int maxSpectrumBands  = AnimeAnalyzerAudioProcessor::maxSpectrumBands;
     static constexpr int numSpectrumCells  = 24; // vertical grid cells for RME-style look
 
-    std::array<float, numSpectrumBands> displayBandLevels {};
-    float meterDecay = 0.75f;
+    juce::ComboBox viewSelector, displaySelector;
+    AnimeAnalyzerAudioProcessor::SpectrumView currentView = AnimeAnalyzerAudioProcessor::SpectrumView::mid;
+    DisplayMode displayMode = DisplayMode::bars;
+    int numBands = maxSpectrumBands; // follows the analysis frames
+
+    std::array<float, maxSpectrumBands> displayBandLevels {};
+    std::array<float, maxSpectrumBands> displayPeakLevels {}, displayAverageLevels {};
+    float meterDecay = 0.75f; // per 1/30 s, scaled to the real frame interval
+
+    // Frame pacing. Updates run on the display's vertical blank, at full rate while
+    // the levels move, slower once they've settled, and barely at all when hidden.
+    // The GIF still gets a frame as soon as its delay runs out.
+    static constexpr double activeFrameInterval = 1.0 / 60.0;
+    static constexpr double idleFrameInterval   = 1.0 / 15.0;
+    static constexpr double hiddenFrameInterval = 0.5;
+    static constexpr double idleAfterSeconds    = 0.5;
+    static constexpr double maxFrameDelta       = 0.25;
+
+    double lastVBlankTime = 0.0, lastUpdateTime = 0.0;
+    double secondsSinceLevelsChanged = 0.0;
+
+    // Layout, set in resized()
+    juce::Rectangle<int> spectrumArea;
+    float columnWidth = 1.0f;
+
+    // Background, title, grid and labels, rendered once per size / scale factor
+    juce::Image staticLayer;
+    float staticLayerScale = 1.0f;
+
+    // Bar heights in pixels as last requested for painting; only columns whose
+    // height changes (or whose GIF frame changes) get repainted
+    std::array<int, maxSpectrumBands> paintedBarHeights {};
+
+    // Peak hold and long-term average markers, tracked the same way
+    std::array<int, maxSpectrumBands> paintedPeakHeights {}, paintedAverageHeights {};
+    static constexpr int markerThickness = 2;
+
+    // Spectrogram history as a ring of columns: new columns overwrite the oldest one in
+    // place and paint draws the two halves either side of the write position, so
+    // the history itself is never redrawn or moved
+    juce::Image spectrogramImage;
+    int spectrogramWriteColumn = 0;
+    std::array<juce::Colour, 256> spectrogramColours;
+
+    // Goniometer: points are added to a persistent intensity buffer, rotated so mono
+    // is vertical, that fades by one factor per frame. The image is refreshed from it
+    // in bulk instead of drawing a path through every point.
+    static constexpr int goniometerSize = 256;
+    static constexpr double goniometerHalfLifeSeconds = 0.12;
+    static constexpr float goniometerPointIntensity = 0.2f;
+
+    std::vector<float> goniometerIntensity, goniometerLevels;
+    float goniometerMaxIntensity = 0.0f;
+    juce::Image goniometerImage;
+    std::array<juce::PixelARGB, 256> goniometerPixels;
+
+    // Decoding and scaling happen on atlasPool; atlases are handed back on the message
+    // thread. A newer atlas size supersedes an older one that hasn't been built yet.
+    // The pool has one thread, so its jobs run in order: the decode always comes
+    // first, and only its jobs touch decodedGifFrames.
+    std::vector<GifDecoder::Frame> decodedGifFrames;
+    bool gifDecodeQueued = false;
+    std::shared_ptr<const GifFrameAtlas> gifAtlas;
+    juce::Rectangle<int> requestedAtlasFrameSize;
+    size_t gifAtlasMemoryBudget = defaultGifAtlasMemoryBudget;
+    std::atomic<int> gifAtlasGeneration { 0 };
+    juce::ThreadPool atlasPool { 1 };
 
-    juce::Array<juce::Image> gifFrames;
     int currentGifFrameIndex = 0;
     double gifTimeAccumulatorSeconds = 0.0;
-    double gifFrameDurationSeconds   = 1.0 / 24.0;
+
+    struct FrameStats
+    {
+        double lastPaintMs = 0.0, averagePaintMs = 0.0;
+        double averageFrameIntervalMs = 0.0, vblankIntervalMs = 0.0;
+        int droppedFrames = 0;
+    };
+
+    void paintFrameStats (juce::Graphics&) const;
+    juce::Rectangle<int> getFrameStatsBounds() const;
+
+    void paintLoadStats (juce::Graphics&) const;
+    juce::Rectangle<int> getLoadStatsBounds() const;
+    void showLoadStatsMenu();
+
+    std::unique_ptr<juce::FileChooser> loadProfileChooser;
+
+    FrameStats frameStats;
+    bool showFrameStats = false;
+
+    juce::VBlankAttachment vblankAttachment { this, [this] (double timestampSeconds) { onVBlank (timestampSeconds); } };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnimeAnalyzerAudioProcessorEditor)
 };
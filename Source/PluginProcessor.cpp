@@ -1,7 +1,5 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include <cmath>
-#include <algorithm>
 
 //==============================================================================
 AnimeAnalyzerAudioProcessor::AnimeAnalyzerAudioProcessor()
@@ -14,39 +12,110 @@ AnimeAnalyzerAudioProcessor::AnimeAnalyzerAudioProcessor()
 #endif
                       )
 {
-    fftFifo.resize (fftSize, 0.0f);
-    fftBuffer.resize (fftSize * 2, 0.0f);
-    magnitudes.resize (fftSize / 2, 0.0f);
+    // Other processes follow the analysis through shared memory; without it the plugin works as before
+    analysisStream.open (AnalysisStreamWriter::createUniqueName());
 
-    for (auto& band : spectrumBandLevels)
-        band.store (0.0f);
+    engine.onFramePublished = [this] (const AnalysisFrame& frame)
+    {
+        analysisStream.write (frame, engine.getSampleRate());
+    };
+
+    fftSizeParameter   = parameters.getRawParameterValue (fftSizeParameterId);
+    windowParameter    = parameters.getRawParameterValue (windowParameterId);
+    bandsParameter     = parameters.getRawParameterValue (bandsParameterId);
+    smoothingParameter = parameters.getRawParameterValue (smoothingParameterId);
+    rangeMinParameter  = parameters.getRawParameterValue (rangeMinParameterId);
+    rangeMaxParameter  = parameters.getRawParameterValue (rangeMaxParameterId);
+    analyzerParameter  = parameters.getRawParameterValue (analyzerParameterId);
+
+    for (auto* id : { &fftSizeParameterId, &windowParameterId, &bandsParameterId,
+                      &smoothingParameterId, &rangeMinParameterId, &rangeMaxParameterId, &analyzerParameterId })
+        parameters.addParameterListener (*id, this);
+
+    pushSpectrumSettings();
+}
+
+AnimeAnalyzerAudioProcessor::~AnimeAnalyzerAudioProcessor()
+{
+    stopBackgroundAnalysis();
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout AnimeAnalyzerAudioProcessor::createParameterLayout()
+{
+    juce::StringArray fftSizes, bandCounts;
+
+    for (int order = AnalysisEngine::minFftOrder; order <= AnalysisEngine::maxFftOrder; ++order)
+        fftSizes.add (juce::String (1 << order));
+
+    for (auto count : bandCountChoices)
+        bandCounts.add (juce::String (count));
+
+    const auto defaultFftSizeIndex = AnalysisEngine::defaultFftOrder - AnalysisEngine::minFftOrder;
+    const auto defaultBandsIndex = (int) bandCountChoices.size() - 1;
+
+    static_assert (bandCountChoices.back() == AnalysisEngine::maxSpectrumBands, "The default band count is the most there can be");
+
+    const auto decibels = juce::AudioParameterFloatAttributes().withLabel ("dB");
+
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    layout.add (std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { fftSizeParameterId, 1 }, "FFT Size", fftSizes, defaultFftSizeIndex),
+                std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { windowParameterId, 1 }, "Window",
+                                                              juce::StringArray { "Hann", "Hamming", "Blackman", "Blackman-Harris", "Flat Top" }, 0),
+                std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { bandsParameterId, 1 }, "Bands", bandCounts, defaultBandsIndex),
+                std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { smoothingParameterId, 1 }, "Smoothing",
+                                                             juce::NormalisableRange<float> (0.0f, 0.99f), 0.8f),
+                std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { rangeMinParameterId, 1 }, "Range Floor",
+                                                             juce::NormalisableRange<float> (-120.0f, -30.0f, 1.0f), -80.0f, decibels),
+                std::make_unique<juce::AudioParameterFloat> (juce::ParameterID { rangeMaxParameterId, 1 }, "Range Ceiling",
+                                                             juce::NormalisableRange<float> (-30.0f, 12.0f, 1.0f), 0.0f, decibels),
+                // Added later, hence the version hint
+                std::make_unique<juce::AudioParameterChoice> (juce::ParameterID { analyzerParameterId, 2 }, "Analyzer",
+                                                              juce::StringArray { "FFT", "Filter Bank" }, 0));
+
+    return layout;
+}
+
+void AnimeAnalyzerAudioProcessor::parameterChanged (const juce::String&, float)
+{
+    pushSpectrumSettings();
 }
 
-AnimeAnalyzerAudioProcessor::~AnimeAnalyzerAudioProcessor() = default;
+void AnimeAnalyzerAudioProcessor::pushSpectrumSettings() noexcept
+{
+    // Called on whichever thread changed the parameter, often the audio thread, so it
+    // only stores atomics; the analysis pool builds the new layout
+    const auto bandsIndex = juce::jlimit (0, (int) bandCountChoices.size() - 1, juce::roundToInt (bandsParameter->load()));
+
+    AnalysisEngine::SpectrumSettings settings;
+    settings.analyzer = (AnalysisEngine::Analyzer) juce::roundToInt (analyzerParameter->load());
+    settings.fftOrder = AnalysisEngine::minFftOrder + juce::roundToInt (fftSizeParameter->load());
+    settings.window = (AnalysisEngine::Window) juce::roundToInt (windowParameter->load());
+    settings.numBands = bandCountChoices[(size_t) bandsIndex];
+    settings.smoothing = smoothingParameter->load();
+    settings.minDecibels = rangeMinParameter->load();
+    settings.maxDecibels = rangeMaxParameter->load();
+
+    engine.setSpectrumSettings (settings);
+}
 
 //==============================================================================
 void AnimeAnalyzerAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    juce::ignoreUnused (samplesPerBlock);
-    currentSampleRate = sampleRate;
-
-    fifoIndex = 0;
-    std::fill (fftFifo.begin(), fftFifo.end(), 0.0f);
-    std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
-    std::fill (magnitudes.begin(), magnitudes.end(), 0.0f);
-
-    rmsLeft.store  (0.0f);
-    rmsRight.store (0.0f);
-    peakLeft.store (0.0f);
-    peakRight.store (0.0f);
-    correlation.store (0.0f);
-
-    for (auto& band : spectrumBandLevels)
-        band.store (0.0f);
+    stopBackgroundAnalysis();
+
+    engine.setChannelLayout (getChannelLayoutOfBus (true, 0));
+    engine.prepare (sampleRate, samplesPerBlock);
+
+    analyseSynchronously = isNonRealtime();
+
+    if (! analyseSynchronously)
+        startBackgroundAnalysis();
 }
 
 void AnimeAnalyzerAudioProcessor::releaseResources()
 {
+    stopBackgroundAnalysis();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -56,8 +125,10 @@ bool AnimeAnalyzerAudioProcessor::isBusesLayoutSupported (const BusesLayout& lay
     juce::ignoreUnused (layouts);
     return true;
    #else
-    auto mainOut = layouts.getMainOutputChannelSet();
-    if (mainOut != juce::AudioChannelSet::stereo())
+    // Anything from mono up to 7.1.4, passed straight through
+    const auto mainOut = layouts.getMainOutputChannelSet();
+
+    if (mainOut.isDisabled() || mainOut.size() > AnalysisEngine::maxChannels)
         return false;
 
    #if ! JucePlugin_IsSynth
@@ -74,204 +145,110 @@ void AnimeAnalyzerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
                                                 juce::MidiBuffer& midiMessages)
 {
     juce::ignoreUnused (midiMessages);
+    processSamples (buffer);
+}
+
+void AnimeAnalyzerAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer,
+                                                juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused (midiMessages);
+    processSamples (buffer);
+}
 
-    const auto numChannels = buffer.getNumChannels();
-    const auto numSamples  = buffer.getNumSamples();
+template <typename SampleType>
+void AnimeAnalyzerAudioProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    const auto numSamples = buffer.getNumSamples();
 
     // Pass-through: clear any extra output channels
     for (int ch = getTotalNumInputChannels(); ch < getTotalNumOutputChannels(); ++ch)
         buffer.clear (ch, 0, numSamples);
 
-    if (numSamples > 0)
-    {
-        double sumSquaresLeft  = 0.0;
-        double sumSquaresRight = 0.0;
-        double sumCross        = 0.0;
-
-        float peakL = 0.0f;
-        float peakR = 0.0f;
-
-        const bool hasLeft  = numChannels > 0;
-        const bool hasRight = numChannels > 1;
-
-        if (hasLeft)
-        {
-            const auto* data = buffer.getReadPointer (0);
-
-            for (int i = 0; i < numSamples; ++i)
-            {
-                const auto s = static_cast<double> (data[i]);
-                sumSquaresLeft += s * s;
-                peakL = juce::jmax (peakL, static_cast<float> (std::abs (data[i])));
-            }
-
-            rmsLeft.store (static_cast<float> (std::sqrt (sumSquaresLeft / numSamples)));
-            peakLeft.store (peakL);
-        }
-
-        if (hasRight)
-        {
-            const auto* data = buffer.getReadPointer (1);
-
-            for (int i = 0; i < numSamples; ++i)
-            {
-                const auto s = static_cast<double> (data[i]);
-                sumSquaresRight += s * s;
-                peakR = juce::jmax (peakR, static_cast<float> (std::abs (data[i])));
-            }
-
-            rmsRight.store (static_cast<float> (std::sqrt (sumSquaresRight / numSamples)));
-            peakRight.store (peakR);
-        }
-
-        if (hasLeft && hasRight)
-        {
-            const auto* left  = buffer.getReadPointer (0);
-            const auto* right = buffer.getReadPointer (1);
-
-            for (int i = 0; i < numSamples; ++i)
-                sumCross += static_cast<double> (left[i]) * static_cast<double> (right[i]);
-
-            const auto denom = std::sqrt (sumSquaresLeft * sumSquaresRight);
-            const auto corr = (denom > 0.0) ? juce::jlimit (-1.0, 1.0, sumCross / denom) : 0.0;
-            correlation.store (static_cast<float> (corr));
-        }
-        else
-        {
-            correlation.store (0.0f);
-        }
-    }
-
-    const bool hasLeft  = numChannels > 0;
-    const bool hasRight = numChannels > 1;
-
-    for (int sample = 0; sample < numSamples; ++sample)
-    {
-        float monoSample = 0.0f;
+    if (numSamples <= 0)
+        return;
 
-        if (hasLeft)
-            monoSample += buffer.getReadPointer (0)[sample];
+    const LoadProfiler::ScopedTimer timer (engine.getProfiler(), LoadProfiler::Section::processBlock,
+                                           numSamples / getSampleRate());
 
-        if (hasRight)
-            monoSample += buffer.getReadPointer (1)[sample];
+    engine.pushBlock (buffer.getArrayOfReadPointers(), getTotalNumInputChannels(), numSamples);
 
-        if (hasLeft && hasRight)
-            monoSample *= 0.5f;
+    if (analyseSynchronously)
+    {
+        // Offline there's no pool and allocating is fine, so new settings apply from this block
+        if (engine.isLayoutUpdatePending())
+            engine.updateSpectrumLayout();
 
-        pushNextSampleIntoFifo (monoSample);
+        engine.processPendingSamples();
     }
 }
 
-//==============================================================================
-void AnimeAnalyzerAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+bool AnimeAnalyzerAudioProcessor::exportLoadProfile (const juce::File& file) const
 {
-    // No params yet
-    destData.setSize (0);
+    return file.replaceWithText (engine.getProfiler().toJson());
 }
 
-void AnimeAnalyzerAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
-{
-    juce::ignoreUnused (data, sizeInBytes);
-}
-
-float AnimeAnalyzerAudioProcessor::getRmsLevel (int channel) const
+//==============================================================================
+void AnimeAnalyzerAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    if (channel == 0)
-        return rmsLeft.load();
-    if (channel == 1)
-        return rmsRight.load();
-    return 0.0f;
-}
+    juce::ValueTree state (stateType);
 
-float AnimeAnalyzerAudioProcessor::getPeakLevel (int channel) const
-{
-    if (channel == 0)
-        return peakLeft.load();
-    if (channel == 1)
-        return peakRight.load();
-    return 0.0f;
-}
+    // The loudness integration, so a session's integrated loudness and LRA survive a reload
+    juce::MemoryBlock loudness;
+    engine.saveLoudnessIntegration (loudness);
+    state.setProperty (loudnessIntegrationProperty, loudness.toBase64Encoding(), nullptr);
+    state.setProperty (spectrogramRowsProperty, getSpectrogramRows(), nullptr);
+    state.setProperty (spectrogramDepthProperty, getSpectrogramDepth(), nullptr);
 
-float AnimeAnalyzerAudioProcessor::getSpectrumBandLevel (int bandIndex) const
-{
-    if (bandIndex < 0 || bandIndex >= numSpectrumBands)
-        return 0.0f;
+    state.appendChild (parameters.copyState(), nullptr);
 
-    return spectrumBandLevels[(size_t) bandIndex].load();
+    if (auto xml = state.createXml())
+        copyXmlToBinary (*xml, destData);
 }
 
-void AnimeAnalyzerAudioProcessor::pushNextSampleIntoFifo (float sample) noexcept
+void AnimeAnalyzerAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    if (fifoIndex < fftSize)
-    {
-        fftFifo[(size_t) fifoIndex++] = sample;
+    const auto xml = getXmlFromBinary (data, sizeInBytes);
 
-        if (fifoIndex == fftSize)
-            performFFTAnalysis();
-    }
-}
+    if (xml == nullptr)
+        return;
 
-void AnimeAnalyzerAudioProcessor::performFFTAnalysis()
-{
-    std::copy (fftFifo.begin(), fftFifo.end(), fftBuffer.begin());
-    window.multiplyWithWindowingTable (fftBuffer.data(), (size_t) fftSize);
+    const auto state = juce::ValueTree::fromXml (*xml);
 
-    fft.performRealOnlyForwardTransform (fftBuffer.data());
+    if (! state.hasType (stateType))
+        return;
 
-    const int numMagnitudes = fftSize / 2;
+    // Sessions saved before the parameters existed keep the defaults
+    if (const auto savedParameters = state.getChildWithName (parametersType); savedParameters.isValid())
+        parameters.replaceState (savedParameters.createCopy());
 
-    for (int bin = 1; bin < numMagnitudes; ++bin)
-    {
-        const auto real = fftBuffer[(size_t) bin * 2];
-        const auto imag = fftBuffer[(size_t) bin * 2 + 1];
-        magnitudes[(size_t) bin] = std::sqrt (real * real + imag * imag) / static_cast<float> (fftSize);
-    }
+    if (state.hasProperty (spectrogramRowsProperty))
+        setSpectrogramRows (state[spectrogramRowsProperty]);
 
-    updateSpectrumBands (magnitudes.data(), numMagnitudes);
+    if (state.hasProperty (spectrogramDepthProperty))
+        setSpectrogramDepth (state[spectrogramDepthProperty]);
 
-    fifoIndex = 0;
+    juce::MemoryBlock loudness;
+
+    if (loudness.fromBase64Encoding (state[loudnessIntegrationProperty].toString()))
+        engine.restoreLoudnessIntegration (loudness.getData(), loudness.getSize());
 }
 
-void AnimeAnalyzerAudioProcessor::updateSpectrumBands (const float* magnitudes, int numMagnitudes)
+//==============================================================================
+void AnimeAnalyzerAudioProcessor::startBackgroundAnalysis()
 {
-    if (currentSampleRate <= 0.0)
-        return;
-
-    const double minFreq = 20.0;
-    const double maxFreq = 20000.0;
-    const double logMin  = std::log10 (minFreq);
-    const double logMax  = std::log10 (maxFreq);
+    if (! registeredWithPool)
+        analysisPool->addClient (*this);
 
-    for (int band = 0; band < numSpectrumBands; ++band)
-    {
-        const double bandStart = logMin + (logMax - logMin) * (static_cast<double> (band) / numSpectrumBands);
-        const double bandEnd   = logMin + (logMax - logMin) * (static_cast<double> (band + 1) / numSpectrumBands);
-
-        const double freqLow  = std::pow (10.0, bandStart);
-        const double freqHigh = std::pow (10.0, bandEnd);
-
-        double magnitudeSum = 0.0;
-        int binCount = 0;
-
-        for (int bin = 1; bin < numMagnitudes; ++bin)
-        {
-            const double binFreq = (static_cast<double> (bin) * currentSampleRate * 0.5) / static_cast<double> (numMagnitudes);
-
-            if (binFreq >= freqLow && binFreq < freqHigh)
-            {
-                magnitudeSum += static_cast<double> (magnitudes[bin]);
-                ++binCount;
-            }
-        }
+    registeredWithPool = true;
+}
 
-        const double magnitude = (binCount > 0) ? magnitudeSum / static_cast<double> (binCount) : 0.0;
-        const float dbValue = juce::Decibels::gainToDecibels (static_cast<float> (magnitude), -100.0f);
-        const float normalized = juce::jlimit (0.0f, 1.0f, juce::jmap (dbValue, -80.0f, 0.0f, 0.0f, 1.0f));
+void AnimeAnalyzerAudioProcessor::stopBackgroundAnalysis()
+{
+    // Once this returns no worker is running our analysis
+    if (registeredWithPool)
+        analysisPool->removeClient (*this);
 
-        const float previous = spectrumBandLevels[(size_t) band].load();
-        const float smoothed = 0.8f * previous + 0.2f * normalized;
-        spectrumBandLevels[(size_t) band].store (smoothed);
-    }
+    registeredWithPool = false;
 }
 
 //==============================================================================
@@ -1,15 +1,16 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
-#include <juce_dsp/juce_dsp.h>
-#include <atomic>
-#include <array>
-#include <vector>
+#include "AnalysisEngine.h"
+#include "AnalysisStreamWriter.h"
+#include "AnalysisWorkerPool.h"
 
-class AnimeAnalyzerAudioProcessor : public juce::AudioProcessor
+class AnimeAnalyzerAudioProcessor : public juce::AudioProcessor,
+                                    private juce::AudioProcessorValueTreeState::Listener,
+                                    private AnalysisWorkerPool::Client
 {
 public:
-    static constexpr int numSpectrumBands = 31;
+    static constexpr int maxSpectrumBands = AnalysisEngine::maxSpectrumBands;
 
     AnimeAnalyzerAudioProcessor();
     ~AnimeAnalyzerAudioProcessor() override;
@@ -24,7 +25,11 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
    #endif
 
+    // Both precisions are analysed natively, so a 64-bit host mix is never converted for us
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -47,39 +52,133 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-    // Simple RMS getter for UI (0.0 - 1.0 approx)
-    float getRmsLevel (int channel) const;
-    float getPeakLevel (int channel) const;
-    float getCorrelation() const { return correlation.load(); }
+    using SpectrumView = AnalysisEngine::SpectrumView;
+
+    /** Meters and all spectrum views from one moment, for the UI. Message thread only;
+        the reference stays valid and unchanged until the next call.
+    */
+    const AnalysisFrame& getLatestAnalysisFrame() noexcept  { return engine.getLatestFrame(); }
+
+    void resetTruePeakHold() noexcept                       { engine.resetTruePeakHold(); }
+
+    /** How the input is mixed to the pair the spectrum shows. Message thread; a new
+        bus layout brings back its default.
+    */
+    void setDownmixMatrix (const DownmixMatrix& newMatrix) noexcept  { engine.setDownmixMatrix (newMatrix); }
+    const DownmixMatrix& getDownmixMatrix() const noexcept          { return engine.getDownmixMatrix(); }
+
+    /** Spectrogram columns for the editor; rows change on the next prepareToPlay(). The row
+        count and the depth are saved with the state.
+    */
+    SpectrogramBuffer& getSpectrogram() noexcept             { return engine.getSpectrogram(); }
+    void setSpectrogramRows (int numRows) noexcept          { engine.setSpectrogramRows (numRows); }
+    int getSpectrogramRows() const noexcept                 { return engine.getSpectrogramRows(); }
+
+    /** How many columns of history the editor's spectrogram keeps, which it caps to
+        its image budget. Any thread; an open editor follows it straight away.
+    */
+    void setSpectrogramDepth (int numColumns) noexcept      { spectrogramDepth.store (juce::jmax (1, numColumns)); }
+    int getSpectrogramDepth() const noexcept                { return spectrogramDepth.load(); }
+
+    static constexpr int defaultSpectrogramDepth = 600;
+
+    /** Decimated left/right points of the analysed pair, for the editor's goniometer. */
+    GoniometerBuffer& getGoniometer() noexcept               { return engine.getGoniometer(); }
+
+    /** Starts a new integrated loudness / LRA measurement. The running one is saved with the state. */
+    void resetLoudness() noexcept                           { engine.resetLoudnessIntegration(); }
+
+    /** Per-bin peak hold and long-term average spectrum; a window of 0 averages since the last reset. */
+    void setSpectrumPeakHold (float holdSeconds, float decayDbPerSecond) noexcept    { engine.setSpectrumPeakHold (holdSeconds, decayDbPerSecond); }
+    void setSpectrumAverageWindow (double seconds) noexcept                         { engine.setSpectrumAverageWindow (seconds); }
+    void resetSpectrumStatistics() noexcept                                         { engine.resetSpectrumStatistics(); }
+
+    /** processBlock and FFT frame timings, readable from any thread. */
+    const LoadProfiler& getLoadProfiler() noexcept          { return engine.getProfiler(); }
+    void resetLoadProfile() noexcept                        { engine.getProfiler().reset(); }
+
+    /** Writes the load profile's summaries and histograms as JSON. */
+    bool exportLoadProfile (const juce::File& file) const;
+
+    /** The shared memory stream every analysis frame is published to (see
+        AnalysisStreamLayout.h), or an empty string if it couldn't be created.
+    */
+    const juce::String& getAnalysisStreamName() const noexcept  { return analysisStream.getName(); }
 
-    float getSpectrumBandLevel (int bandIndex) const;
-    static constexpr int getNumSpectrumBands() { return numSpectrumBands; }
+    /** The spectrum's analyzer, FFT size, window, band count, smoothing and dB range, saved
+        with the state. Any thread may change them; see AnalysisEngine::SpectrumSettings.
+    */
+    juce::AudioProcessorValueTreeState& getParameters() noexcept     { return parameters; }
+
+    /** The band count the analysis is running with, which trails the parameter
+        while a new layout is built.
+    */
+    int getNumSpectrumBands() const noexcept                        { return engine.getNumSpectrumBands(); }
+    double getSpectrumBandCentreFrequency (int bandIndex) const     { return AnalysisEngine::getSpectrumBandCentreFrequency (bandIndex, getNumSpectrumBands()); }
+
+    using AnalysisOverlap = AnalysisEngine::Overlap;
+
+    void setAnalysisOverlap (AnalysisOverlap newOverlap) noexcept   { engine.setOverlap (newOverlap); }
+    AnalysisOverlap getAnalysisOverlap() const noexcept             { return engine.getOverlap(); }
 
 private:
-    double currentSampleRate { 44100.0 };
+    //==============================================================================
+    static inline const juce::Identifier stateType { "ANIME_ANALYZER_STATE" };
+    static inline const juce::Identifier loudnessIntegrationProperty { "loudnessIntegration" };
+    static inline const juce::Identifier spectrogramRowsProperty { "spectrogramRows" };
+    static inline const juce::Identifier spectrogramDepthProperty { "spectrogramDepth" };
+    static inline const juce::Identifier parametersType { "PARAMETERS" };
+
+    static inline const juce::String fftSizeParameterId   { "fftSize" };
+    static inline const juce::String windowParameterId    { "window" };
+    static inline const juce::String bandsParameterId     { "bands" };
+    static inline const juce::String smoothingParameterId { "smoothing" };
+    static inline const juce::String rangeMinParameterId  { "rangeMin" };
+    static inline const juce::String rangeMaxParameterId  { "rangeMax" };
+    static inline const juce::String analyzerParameterId  { "analyzer" };
+
+    static constexpr std::array<int, 4> bandCountChoices { 10, 15, 20, 31 };
+
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    void pushSpectrumSettings() noexcept;
+
+    AnalysisStreamWriter analysisStream; // written from the engine's analysis side
+    AnalysisEngine engine;
+
+    juce::SharedResourcePointer<AnalysisWorkerPool> analysisPool;
+    bool registeredWithPool = false;
+
+    std::atomic<int> spectrogramDepth { defaultSpectrogramDepth };
+
+    juce::AudioProcessorValueTreeState parameters { *this, nullptr, parametersType, createParameterLayout() };
 
-    static constexpr int fftOrder = 11; // 2048 samples
-    static constexpr int fftSize  = 1 << fftOrder;
+    // Read from any thread that changes a parameter, so they're looked up once here
+    std::atomic<float>* fftSizeParameter = nullptr;
+    std::atomic<float>* windowParameter = nullptr;
+    std::atomic<float>* bandsParameter = nullptr;
+    std::atomic<float>* smoothingParameter = nullptr;
+    std::atomic<float>* rangeMinParameter = nullptr;
+    std::atomic<float>* rangeMaxParameter = nullptr;
+    std::atomic<float>* analyzerParameter = nullptr;
 
-    juce::dsp::FFT fft { fftOrder };
-    juce::dsp::WindowingFunction<float> window { static_cast<size_t> (fftSize), juce::dsp::WindowingFunction<float>::hann, false };
+    // Offline renders analyse inside processBlock so every frame is seen, in order
+    bool analyseSynchronously { false };
 
-    std::vector<float> fftFifo;
-    std::vector<float> fftBuffer;
-    std::vector<float> magnitudes;
-    int fifoIndex { 0 };
+    template <typename SampleType>
+    void processSamples (juce::AudioBuffer<SampleType>& buffer) noexcept;
 
-    std::array<std::atomic<float>, numSpectrumBands> spectrumBandLevels {};
+    // Drains the engine's sample ring and runs the FFT on the shared pool's
+    // workers, so processBlock never has to
+    void runAnalysis (int frameRateDivider) noexcept override  { engine.processPendingSamples (frameRateDivider); }
 
-    std::atomic<float> rmsLeft  { 0.0f };
-    std::atomic<float> rmsRight { 0.0f };
-    std::atomic<float> peakLeft  { 0.0f };
-    std::atomic<float> peakRight { 0.0f };
-    std::atomic<float> correlation { 0.0f };
+    // New spectrum layouts are built there too, between rounds, once the settings change
+    bool needsBackgroundWork() const noexcept override         { return engine.isLayoutUpdatePending(); }
+    void runBackgroundWork() override                           { engine.updateSpectrumLayout(); }
 
-    void pushNextSampleIntoFifo (float sample) noexcept;
-    void performFFTAnalysis();
-    void updateSpectrumBands (const float* magnitudes, int numMagnitudes);
+    void startBackgroundAnalysis();
+    void stopBackgroundAnalysis();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnimeAnalyzerAudioProcessor)
 };
@@ -0,0 +1,25 @@
+#include "SpectrogramBuffer.h"
+
+SpectrogramBuffer::SpectrogramBuffer()
+    : columns ((size_t) (capacity * maxRows), 0)
+{
+}
+
+void SpectrogramBuffer::setNumRows (int newNumRows) noexcept
+{
+    numRows.store (juce::jlimit (minRows, maxRows, newNumRows), std::memory_order_relaxed);
+    reset();
+}
+
+void SpectrogramBuffer::push (const float* levels) noexcept
+{
+    if (fifo.getFreeSpace() == 0)
+        return;
+
+    const auto scope = fifo.write (1);
+    auto* column = columns.data() + (size_t) scope.startIndex1 * maxRows;
+    const auto rows = getNumRows();
+
+    for (int row = 0; row < rows; ++row)
+        column[row] = (juce::uint8) juce::roundToInt (juce::jlimit (0.0f, 1.0f, levels[row]) * 255.0f);
+}
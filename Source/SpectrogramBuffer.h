@@ -0,0 +1,90 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+/**
+    Hands spectrogram columns from the analysis side to one reader (the editor).
+
+    Each column is one analysis frame's levels on a log-frequency axis, lowest
+    frequency first, quantised to a byte so the reader can index a colour
+    table with it directly. The storage is allocated once for the largest row
+    count, so changing the resolution never reallocates under the reader.
+
+    Clearing it or changing the row count is the writer's call, but the reader
+    may be in the middle of a read, so the writer only leaves a request for it;
+    the reader then drops every column that came before, and picks up the new
+    row count, at the start of its next read.
+*/
+class SpectrogramBuffer
+{
+public:
+    static constexpr int minRows = 16;
+    static constexpr int maxRows = 512;
+    static constexpr int defaultRows = 128;
+
+    // Columns in flight; at the fastest hop that's a couple of seconds of frames
+    static constexpr int capacity = 512;
+
+    SpectrogramBuffer();
+
+    /** Writer: changes the row count of the columns pushed from now on, and clears the
+        buffer. Call it from the writer's thread, or while the writer isn't running.
+    */
+    void setNumRows (int newNumRows) noexcept;
+    int getNumRows() const noexcept                     { return numRows.load (std::memory_order_relaxed); }
+
+    /** Writer: clears the buffer, as setNumRows() does. */
+    void reset() noexcept                               { pendingReaderRows.store (getNumRows(), std::memory_order_release); }
+
+    /** Reader: the row count of the columns readAll() hands over next. */
+    int getNumReadableRows() noexcept
+    {
+        applyPendingReset();
+        return readerRows;
+    }
+
+    /** Writer: quantises getNumRows() levels in 0..1 into a new column. The column is
+        dropped if the reader has fallen a whole buffer behind.
+    */
+    void push (const float* levels) noexcept;
+
+    /** Reader: calls callback (const juce::uint8* column, int numRows) for every column
+        pushed since the last call, oldest first, and returns how many there were.
+    */
+    template <typename Callback>
+    int readAll (Callback&& callback)
+    {
+        applyPendingReset();
+
+        const auto scope = fifo.read (fifo.getNumReady());
+
+        scope.forEach ([&] (int index) { callback (columns.data() + (size_t) index * maxRows, readerRows); });
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+private:
+    // Reader: everything written before the request is dropped, which can only
+    // take a few columns from after it along with it
+    void applyPendingReset() noexcept
+    {
+        const auto rows = pendingReaderRows.exchange (0, std::memory_order_acquire);
+
+        if (rows > 0)
+        {
+            fifo.finishedRead (fifo.getNumReady());
+            readerRows = rows;
+        }
+    }
+
+    juce::AbstractFifo fifo { capacity };
+    std::vector<juce::uint8> columns;
+    std::atomic<int> numRows { defaultRows };
+
+    std::atomic<int> pendingReaderRows { 0 }; // 0 when nothing is pending
+    int readerRows = defaultRows;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrogramBuffer)
+};
@@ -0,0 +1,103 @@
+#include "SpectrumBandMap.h"
+#include <cmath>
+#include <algorithm>
+
+void SpectrumBandMap::build (double sampleRate, int fftSize, int numBands,
+                             double minFrequency, double maxFrequency)
+{
+    entries.clear();
+    bandOffsets.assign (1, 0);
+
+    if (sampleRate <= 0.0 || fftSize < 4 || numBands <= 0)
+    {
+        bandOffsets.assign ((size_t) std::max (0, numBands) + 1, 0);
+        return;
+    }
+
+    const int numMagnitudes = fftSize / 2;
+    const int lastBin       = numMagnitudes - 1;
+    const double binWidth   = sampleRate / static_cast<double> (fftSize);
+    const double nyquist    = static_cast<double> (lastBin) * binWidth;
+
+    const double logMin = std::log10 (minFrequency);
+    const double logMax = std::log10 (maxFrequency);
+
+    entries.reserve ((size_t) numMagnitudes + (size_t) numBands * 2);
+
+    std::vector<Entry> bandEntries;
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        const double freqLow  = std::pow (10.0, logMin + (logMax - logMin) * (static_cast<double> (band)     / numBands));
+        const double freqHigh = std::min (nyquist,
+                                          std::pow (10.0, logMin + (logMax - logMin) * (static_cast<double> (band + 1) / numBands)));
+
+        bandEntries.clear();
+
+        if (freqLow < freqHigh)
+        {
+            if (freqHigh - freqLow < binWidth)
+            {
+                // Narrower than one bin: interpolate between the two bins around the centre
+                const double position = std::sqrt (freqLow * freqHigh) / binWidth;
+                const int lowerBin    = std::clamp ((int) std::floor (position), 1, lastBin);
+                const int upperBin    = std::min (lowerBin + 1, lastBin);
+                const double frac     = std::clamp (position - lowerBin, 0.0, 1.0);
+
+                if (upperBin == lowerBin || frac <= 0.0)
+                {
+                    bandEntries.push_back ({ lowerBin, 1.0f });
+                }
+                else
+                {
+                    bandEntries.push_back ({ lowerBin, static_cast<float> (1.0 - frac) });
+                    bandEntries.push_back ({ upperBin, static_cast<float> (frac) });
+                }
+            }
+            else
+            {
+                // Each bin covers [centre - width/2, centre + width/2); weight it by how much of that lies in the band
+                const int firstBin = std::max (1, (int) std::floor (freqLow / binWidth + 0.5));
+                const int endBin   = std::min (lastBin, (int) std::ceil (freqHigh / binWidth + 0.5));
+
+                double weightSum = 0.0;
+
+                for (int bin = firstBin; bin <= endBin; ++bin)
+                {
+                    const double binLow  = (bin - 0.5) * binWidth;
+                    const double binHigh = (bin + 0.5) * binWidth;
+                    const double overlap = std::min (freqHigh, binHigh) - std::max (freqLow, binLow);
+
+                    if (overlap > 0.0)
+                    {
+                        bandEntries.push_back ({ bin, static_cast<float> (overlap / binWidth) });
+                        weightSum += overlap / binWidth;
+                    }
+                }
+
+                for (auto& entry : bandEntries)
+                    entry.weight = static_cast<float> (entry.weight / weightSum);
+            }
+        }
+
+        entries.insert (entries.end(), bandEntries.begin(), bandEntries.end());
+        bandOffsets.push_back ((int) entries.size());
+    }
+}
+
+void SpectrumBandMap::apply (const float* magnitudes, float* bandMagnitudes) const noexcept
+{
+    const auto* entry = entries.data();
+    const int numBands = getNumBands();
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        const auto* end = entries.data() + bandOffsets[(size_t) band + 1];
+        float sum = 0.0f;
+
+        for (; entry != end; ++entry)
+            sum += entry->weight * magnitudes[entry->bin];
+
+        bandMagnitudes[band] = sum;
+    }
+}
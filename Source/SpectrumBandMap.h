@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+//==============================================================================
+/**
+    Precomputed sparse mapping from FFT magnitude bins to log-spaced display bands.
+
+    Each band stores the bins it overlaps together with the fraction of each bin
+    that falls inside the band, normalised so that the weights of a band sum to
+    one. Bands narrower than a single bin fall back to linearly interpolating the
+    two bins around the band's centre frequency, so low bands never read as
+    silence just because no bin centre lands inside them.
+
+    build() allocates and does all the log/pow work, so call it from
+    prepareToPlay(); apply() is a single allocation-free pass over the entries.
+*/
+class SpectrumBandMap
+{
+public:
+    SpectrumBandMap() = default;
+
+    void build (double sampleRate, int fftSize, int numBands,
+                double minFrequency, double maxFrequency);
+
+    /** Reduces fftSize / 2 magnitudes into getNumBands() weighted band averages. */
+    void apply (const float* magnitudes, float* bandMagnitudes) const noexcept;
+
+    int getNumBands() const noexcept                { return (int) bandOffsets.size() - 1; }
+    int getNumEntries() const noexcept              { return (int) entries.size(); }
+
+private:
+    struct Entry
+    {
+        int bin;
+        float weight;
+    };
+
+    // Entries are grouped by band and sorted by bin, so apply() walks the
+    // magnitudes front to back exactly once
+    std::vector<Entry> entries;
+    std::vector<int> bandOffsets { 0 };
+};
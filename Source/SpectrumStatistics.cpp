@@ -0,0 +1,111 @@
+#include "SpectrumStatistics.h"
+#include <algorithm>
+#include <cmath>
+
+void SpectrumStatistics::prepare (int newNumBins)
+{
+    numBins = std::max (0, newNumBins);
+
+    peaks.assign ((size_t) numBins, 0.0f);
+    peakHoldRemaining.assign ((size_t) numBins, 0.0f);
+    totalPower.assign ((size_t) numBins, 0.0);
+    segmentPower.assign ((size_t) numBins * numSegments, 0.0);
+
+    reset();
+}
+
+void SpectrumStatistics::reset() noexcept
+{
+    std::fill (peaks.begin(), peaks.end(), 0.0f);
+    std::fill (peakHoldRemaining.begin(), peakHoldRemaining.end(), 0.0f);
+
+    std::fill (totalPower.begin(), totalPower.end(), 0.0);
+    std::fill (segmentPower.begin(), segmentPower.end(), 0.0);
+    segmentSeconds.fill (0.0);
+    totalSeconds = 0.0;
+    currentSegment = 0;
+}
+
+void SpectrumStatistics::setPeakHold (float holdSeconds, float decayDbPerSecond) noexcept
+{
+    peakHoldSeconds = std::max (0.0f, holdSeconds);
+    peakDecayDbPerSecond = std::max (0.0f, decayDbPerSecond);
+}
+
+void SpectrumStatistics::setAverageWindow (double seconds) noexcept
+{
+    averageWindowSeconds = std::max (0.0, seconds);
+
+    std::fill (totalPower.begin(), totalPower.end(), 0.0);
+    std::fill (segmentPower.begin(), segmentPower.end(), 0.0);
+    segmentSeconds.fill (0.0);
+    totalSeconds = 0.0;
+    currentSegment = 0;
+}
+
+//==============================================================================
+void SpectrumStatistics::addFrame (const float* magnitudes, double frameSeconds) noexcept
+{
+    const auto dt = (float) frameSeconds;
+    const auto decay = std::pow (10.0f, -peakDecayDbPerSecond * dt / 20.0f);
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        auto& peak = peaks[(size_t) bin];
+        auto& holdRemaining = peakHoldRemaining[(size_t) bin];
+
+        if (magnitudes[bin] >= peak)
+        {
+            peak = magnitudes[bin];
+            holdRemaining = peakHoldSeconds;
+        }
+        else if (holdRemaining > 0.0f)
+        {
+            holdRemaining -= dt;
+        }
+        else
+        {
+            peak = std::max (magnitudes[bin], peak * decay);
+        }
+    }
+
+    if (averageWindowSeconds > 0.0 && segmentSeconds[(size_t) currentSegment] >= averageWindowSeconds / numSegments)
+        startNextSegment();
+
+    auto* segment = segmentPower.data() + (size_t) currentSegment * (size_t) numBins;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        const auto power = (double) magnitudes[bin] * (double) magnitudes[bin] * frameSeconds;
+        totalPower[(size_t) bin] += power;
+        segment[bin] += power;
+    }
+
+    segmentSeconds[(size_t) currentSegment] += frameSeconds;
+    totalSeconds += frameSeconds;
+}
+
+void SpectrumStatistics::startNextSegment() noexcept
+{
+    currentSegment = (currentSegment + 1) % numSegments;
+
+    // The segment being reused is the oldest one in the window
+    auto* oldest = segmentPower.data() + (size_t) currentSegment * (size_t) numBins;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        totalPower[(size_t) bin] = std::max (0.0, totalPower[(size_t) bin] - oldest[bin]);
+        oldest[bin] = 0.0;
+    }
+
+    totalSeconds = std::max (0.0, totalSeconds - segmentSeconds[(size_t) currentSegment]);
+    segmentSeconds[(size_t) currentSegment] = 0.0;
+}
+
+void SpectrumStatistics::getAverageMagnitudes (float* destination) const noexcept
+{
+    const auto scale = totalSeconds > 0.0 ? 1.0 / totalSeconds : 0.0;
+
+    for (int bin = 0; bin < numBins; ++bin)
+        destination[bin] = (float) std::sqrt (totalPower[(size_t) bin] * scale);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+//==============================================================================
+/**
+    Peak hold and long-term average of one magnitude spectrum, kept per bin.
+
+    Each bin's peak holds for the hold time and then falls at a fixed rate in
+    dB per second.
+
+    The average is the power mean over a sliding window, kept as running sums.
+    The window is split into numSegments segments: every frame is added to the
+    current segment and to the running total, and when the window moves on the
+    oldest segment is subtracted again. A frame costs the same whatever the
+    window length. A window of 0 averages everything since the last reset.
+
+    Frames carry their own duration, so stages running at different rates, and
+    changes of overlap, are all weighted by the time they cover.
+
+    prepare() allocates; everything else is allocation-free.
+*/
+class SpectrumStatistics
+{
+public:
+    static constexpr int numSegments = 16;
+
+    SpectrumStatistics() = default;
+
+    void prepare (int numBins);
+    void reset() noexcept;
+
+    /** Applies from the next frame. */
+    void setPeakHold (float holdSeconds, float decayDbPerSecond) noexcept;
+
+    /** Clears the average. */
+    void setAverageWindow (double seconds) noexcept;
+
+    void addFrame (const float* magnitudes, double frameSeconds) noexcept;
+
+    const float* getPeakMagnitudes() const noexcept     { return peaks.data(); }
+
+    /** Writes the RMS magnitude of each bin over the window. */
+    void getAverageMagnitudes (float* destination) const noexcept;
+
+    /** How much time the average currently covers. */
+    double getAverageSeconds() const noexcept           { return totalSeconds; }
+
+private:
+    int numBins = 0;
+
+    std::vector<float> peaks, peakHoldRemaining;
+    float peakHoldSeconds = 1.0f, peakDecayDbPerSecond = 12.0f;
+
+    double averageWindowSeconds = 0.0;
+    std::vector<double> totalPower;
+    std::vector<double> segmentPower; // numSegments rows of numBins
+    std::array<double, numSegments> segmentSeconds {};
+    double totalSeconds = 0.0;
+    int currentSegment = 0;
+
+    void startNextSegment() noexcept;
+};
@@ -0,0 +1,115 @@
+#include "StereoMeterKernelImpl.h"
+#include <juce_core/juce_core.h>
+
+#if ANIME_ANALYZER_HAS_SSE2_KERNEL
+ #include <emmintrin.h>
+#endif
+
+#if ANIME_ANALYZER_HAS_NEON_KERNEL
+ #include <arm_neon.h>
+#endif
+
+namespace StereoMeterKernel
+{
+namespace detail
+{
+   #if ANIME_ANALYZER_HAS_SSE2_KERNEL
+    struct SSE2Ops
+    {
+        using Vector = __m128;
+        static constexpr int width = 4;
+
+        static Vector zero() noexcept                                       { return _mm_setzero_ps(); }
+        static Vector broadcast (float x) noexcept                          { return _mm_set1_ps (x); }
+        static Vector load (const float* p) noexcept                        { return _mm_loadu_ps (p); }
+        static void store (float* p, Vector v) noexcept                     { _mm_storeu_ps (p, v); }
+        static Vector add (Vector a, Vector b) noexcept                     { return _mm_add_ps (a, b); }
+        static Vector mul (Vector a, Vector b) noexcept                     { return _mm_mul_ps (a, b); }
+        static Vector multiplyAdd (Vector acc, Vector a, Vector b) noexcept { return _mm_add_ps (acc, _mm_mul_ps (a, b)); }
+        static Vector max (Vector a, Vector b) noexcept                     { return _mm_max_ps (a, b); }
+        static Vector abs (Vector a) noexcept                               { return _mm_andnot_ps (_mm_set1_ps (-0.0f), a); }
+
+        static float sum (Vector a) noexcept
+        {
+            const auto pairs = _mm_add_ps (a, _mm_movehl_ps (a, a));
+            return _mm_cvtss_f32 (_mm_add_ss (pairs, _mm_shuffle_ps (pairs, pairs, 1)));
+        }
+
+        static float maxElement (Vector a) noexcept
+        {
+            const auto pairs = _mm_max_ps (a, _mm_movehl_ps (a, a));
+            return _mm_cvtss_f32 (_mm_max_ss (pairs, _mm_shuffle_ps (pairs, pairs, 1)));
+        }
+    };
+   #endif
+
+   #if ANIME_ANALYZER_HAS_NEON_KERNEL
+    struct NEONOps
+    {
+        using Vector = float32x4_t;
+        static constexpr int width = 4;
+
+        static Vector zero() noexcept                                       { return vdupq_n_f32 (0.0f); }
+        static Vector broadcast (float x) noexcept                          { return vdupq_n_f32 (x); }
+        static Vector load (const float* p) noexcept                        { return vld1q_f32 (p); }
+        static void store (float* p, Vector v) noexcept                     { vst1q_f32 (p, v); }
+        static Vector add (Vector a, Vector b) noexcept                     { return vaddq_f32 (a, b); }
+        static Vector mul (Vector a, Vector b) noexcept                     { return vmulq_f32 (a, b); }
+        static Vector multiplyAdd (Vector acc, Vector a, Vector b) noexcept { return vmlaq_f32 (acc, a, b); }
+        static Vector max (Vector a, Vector b) noexcept                     { return vmaxq_f32 (a, b); }
+        static Vector abs (Vector a) noexcept                               { return vabsq_f32 (a); }
+
+        static float sum (Vector a) noexcept
+        {
+            const auto pairs = vadd_f32 (vget_low_f32 (a), vget_high_f32 (a));
+            return vget_lane_f32 (vpadd_f32 (pairs, pairs), 0);
+        }
+
+        static float maxElement (Vector a) noexcept
+        {
+            const auto pairs = vmax_f32 (vget_low_f32 (a), vget_high_f32 (a));
+            return vget_lane_f32 (vpmax_f32 (pairs, pairs), 0);
+        }
+    };
+   #endif
+}
+
+//==============================================================================
+void processScalar (const float* left, const float* right, float* mono,
+                    int numSamples, StereoMeterStats& stats) noexcept
+{
+    detail::process<detail::ScalarOps> (left, right, mono, numSamples, stats);
+}
+
+#if ANIME_ANALYZER_HAS_SSE2_KERNEL
+void processSSE2 (const float* left, const float* right, float* mono,
+                  int numSamples, StereoMeterStats& stats) noexcept
+{
+    detail::process<detail::SSE2Ops> (left, right, mono, numSamples, stats);
+}
+#endif
+
+#if ANIME_ANALYZER_HAS_NEON_KERNEL
+void processNEON (const float* left, const float* right, float* mono,
+                  int numSamples, StereoMeterStats& stats) noexcept
+{
+    detail::process<detail::NEONOps> (left, right, mono, numSamples, stats);
+}
+#endif
+
+Function getBestImplementation() noexcept
+{
+   #if ANIME_ANALYZER_HAS_AVX2_KERNEL
+    if (juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+        return processAVX2;
+   #endif
+
+   #if ANIME_ANALYZER_HAS_SSE2_KERNEL
+    return processSSE2;
+   #elif ANIME_ANALYZER_HAS_NEON_KERNEL
+    return processNEON;
+   #else
+    return processScalar;
+   #endif
+}
+}
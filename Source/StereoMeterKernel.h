@@ -0,0 +1,52 @@
+#pragma once
+
+//==============================================================================
+/** Running sums for one metered stereo block. */
+struct StereoMeterStats
+{
+    double sumSquaresLeft  = 0.0;
+    double sumSquaresRight = 0.0;
+    double sumCross        = 0.0;
+
+    float peakLeft  = 0.0f;
+    float peakRight = 0.0f;
+};
+
+//==============================================================================
+/**
+    Fused metering pass: one walk over a stereo block produces the per-channel
+    sum of squares and abs peak, the L*R cross-sum and, if mono is non-null,
+    the (L + R) / 2 mix. Results are added to stats, so a block can be metered
+    in several pieces (e.g. the two halves of a ring buffer write).
+
+    Lanes accumulate in float and are flushed to the double totals every few
+    thousand samples, which keeps the error well below what a meter can show.
+*/
+namespace StereoMeterKernel
+{
+    using Function = void (*) (const float* left, const float* right, float* mono,
+                               int numSamples, StereoMeterStats& stats) noexcept;
+
+    void processScalar (const float* left, const float* right, float* mono,
+                        int numSamples, StereoMeterStats& stats) noexcept;
+
+   #if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define ANIME_ANALYZER_HAS_SSE2_KERNEL 1
+    void processSSE2 (const float* left, const float* right, float* mono,
+                      int numSamples, StereoMeterStats& stats) noexcept;
+   #endif
+
+   #if defined (__ARM_NEON) || defined (__ARM_NEON__) || defined (_M_ARM64)
+    #define ANIME_ANALYZER_HAS_NEON_KERNEL 1
+    void processNEON (const float* left, const float* right, float* mono,
+                      int numSamples, StereoMeterStats& stats) noexcept;
+   #endif
+
+   #if ANIME_ANALYZER_HAS_AVX2_KERNEL // set by CMake when the AVX2 translation unit is built
+    void processAVX2 (const float* left, const float* right, float* mono,
+                      int numSamples, StereoMeterStats& stats) noexcept;
+   #endif
+
+    /** Returns the widest implementation the running CPU supports. */
+    Function getBestImplementation() noexcept;
+}
@@ -0,0 +1,73 @@
+// AVX2/FMA code, so nothing in here may be called unless getBestImplementation()
+// has checked the CPU. The file itself is built for the baseline ISA: only the
+// functions defined between the pragmas below target AVX2, and they all have
+// internal linkage apart from processAVX2, so no AVX2 copy of an inline function
+// can stand in for another file's. MSVC needs neither, as it takes AVX2
+// intrinsics at any /arch.
+
+#include "StereoMeterKernel.h"
+
+#if ANIME_ANALYZER_HAS_AVX2_KERNEL // set by CMake on x86
+#include <immintrin.h>
+
+#if defined (__clang__)
+ #pragma clang attribute push (__attribute__ ((target ("avx2,fma"))), apply_to = function)
+#elif defined (__GNUC__)
+ #pragma GCC push_options
+ #pragma GCC target ("avx2,fma")
+#endif
+
+#include "StereoMeterKernelImpl.h"
+
+namespace StereoMeterKernel
+{
+namespace detail
+{
+namespace
+{
+    struct AVX2Ops
+    {
+        using Vector = __m256;
+        static constexpr int width = 8;
+
+        static Vector zero() noexcept                                       { return _mm256_setzero_ps(); }
+        static Vector broadcast (float x) noexcept                          { return _mm256_set1_ps (x); }
+        static Vector load (const float* p) noexcept                        { return _mm256_loadu_ps (p); }
+        static void store (float* p, Vector v) noexcept                     { _mm256_storeu_ps (p, v); }
+        static Vector add (Vector a, Vector b) noexcept                     { return _mm256_add_ps (a, b); }
+        static Vector mul (Vector a, Vector b) noexcept                     { return _mm256_mul_ps (a, b); }
+        static Vector multiplyAdd (Vector acc, Vector a, Vector b) noexcept { return _mm256_fmadd_ps (a, b, acc); }
+        static Vector max (Vector a, Vector b) noexcept                     { return _mm256_max_ps (a, b); }
+        static Vector abs (Vector a) noexcept                               { return _mm256_andnot_ps (_mm256_set1_ps (-0.0f), a); }
+
+        static float sum (Vector a) noexcept
+        {
+            auto quad  = _mm_add_ps (_mm256_castps256_ps128 (a), _mm256_extractf128_ps (a, 1));
+            auto pairs = _mm_add_ps (quad, _mm_movehl_ps (quad, quad));
+            return _mm_cvtss_f32 (_mm_add_ss (pairs, _mm_shuffle_ps (pairs, pairs, 1)));
+        }
+
+        static float maxElement (Vector a) noexcept
+        {
+            auto quad  = _mm_max_ps (_mm256_castps256_ps128 (a), _mm256_extractf128_ps (a, 1));
+            auto pairs = _mm_max_ps (quad, _mm_movehl_ps (quad, quad));
+            return _mm_cvtss_f32 (_mm_max_ss (pairs, _mm_shuffle_ps (pairs, pairs, 1)));
+        }
+    };
+}
+}
+
+void processAVX2 (const float* left, const float* right, float* mono,
+                  int numSamples, StereoMeterStats& stats) noexcept
+{
+    detail::process<detail::AVX2Ops> (left, right, mono, numSamples, stats);
+}
+}
+
+#if defined (__clang__)
+ #pragma clang attribute pop
+#elif defined (__GNUC__)
+ #pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,118 @@
+#pragma once
+
+// Shared body of the metering kernels. Each implementation file includes this
+// after defining an Ops struct for its instruction set; it is not a public header.
+//
+// Everything here has internal linkage and calls nothing from the standard
+// library, so the AVX2 file's copies (built for AVX2) can never be picked by the
+// linker in place of another file's baseline ones.
+
+#include "StereoMeterKernel.h"
+
+namespace StereoMeterKernel
+{
+namespace detail
+{
+namespace
+{
+    inline float maxOf (float a, float b) noexcept      { return a > b ? a : b; }
+    inline float absOf (float x) noexcept               { return x < 0.0f ? -x : x; }
+
+    /** Ops for plain scalar code: a "vector" of one float. */
+    struct ScalarOps
+    {
+        using Vector = float;
+        static constexpr int width = 1;
+
+        static Vector zero() noexcept                                       { return 0.0f; }
+        static Vector broadcast (float x) noexcept                          { return x; }
+        static Vector load (const float* p) noexcept                        { return *p; }
+        static void store (float* p, Vector v) noexcept                     { *p = v; }
+        static Vector add (Vector a, Vector b) noexcept                     { return a + b; }
+        static Vector mul (Vector a, Vector b) noexcept                     { return a * b; }
+        static Vector multiplyAdd (Vector acc, Vector a, Vector b) noexcept { return acc + a * b; }
+        static Vector max (Vector a, Vector b) noexcept                     { return a > b ? a : b; }
+        static Vector abs (Vector a) noexcept                               { return absOf (a); }
+        static float sum (Vector a) noexcept                                { return a; }
+        static float maxElement (Vector a) noexcept                         { return a; }
+    };
+
+    template <typename Ops, bool writeMono>
+    inline void processBlock (const float* left, const float* right, float* mono,
+                              int numSamples, StereoMeterStats& stats) noexcept
+    {
+        using Vector = typename Ops::Vector;
+        constexpr int width = Ops::width;
+        constexpr int samplesPerFlush = 4096;
+
+        const auto half = Ops::broadcast (0.5f);
+        auto peakL = Ops::zero();
+        auto peakR = Ops::zero();
+
+        const int vectorEnd = numSamples - numSamples % width;
+        int i = 0;
+
+        while (i < vectorEnd)
+        {
+            Vector sumL  = Ops::zero();
+            Vector sumR  = Ops::zero();
+            Vector sumLR = Ops::zero();
+
+            const int chunkEnd = vectorEnd - i < samplesPerFlush ? vectorEnd : i + samplesPerFlush;
+
+            for (; i < chunkEnd; i += width)
+            {
+                const auto l = Ops::load (left + i);
+                const auto r = Ops::load (right + i);
+
+                sumL  = Ops::multiplyAdd (sumL,  l, l);
+                sumR  = Ops::multiplyAdd (sumR,  r, r);
+                sumLR = Ops::multiplyAdd (sumLR, l, r);
+
+                peakL = Ops::max (peakL, Ops::abs (l));
+                peakR = Ops::max (peakR, Ops::abs (r));
+
+                if constexpr (writeMono)
+                    Ops::store (mono + i, Ops::mul (Ops::add (l, r), half));
+            }
+
+            stats.sumSquaresLeft  += static_cast<double> (Ops::sum (sumL));
+            stats.sumSquaresRight += static_cast<double> (Ops::sum (sumR));
+            stats.sumCross        += static_cast<double> (Ops::sum (sumLR));
+        }
+
+        float peakLeft  = maxOf (stats.peakLeft,  Ops::maxElement (peakL));
+        float peakRight = maxOf (stats.peakRight, Ops::maxElement (peakR));
+
+        for (; i < numSamples; ++i)
+        {
+            const auto l = left[i];
+            const auto r = right[i];
+
+            stats.sumSquaresLeft  += static_cast<double> (l) * l;
+            stats.sumSquaresRight += static_cast<double> (r) * r;
+            stats.sumCross        += static_cast<double> (l) * r;
+
+            peakLeft  = maxOf (peakLeft,  absOf (l));
+            peakRight = maxOf (peakRight, absOf (r));
+
+            if constexpr (writeMono)
+                mono[i] = (l + r) * 0.5f;
+        }
+
+        stats.peakLeft  = peakLeft;
+        stats.peakRight = peakRight;
+    }
+
+    template <typename Ops>
+    inline void process (const float* left, const float* right, float* mono,
+                         int numSamples, StereoMeterStats& stats) noexcept
+    {
+        if (mono != nullptr)
+            processBlock<Ops, true> (left, right, mono, numSamples, stats);
+        else
+            processBlock<Ops, false> (left, right, mono, numSamples, stats);
+    }
+}
+}
+}
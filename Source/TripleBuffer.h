@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+//==============================================================================
+/**
+    Wait-free hand-over of a value from one writer thread to one reader thread.
+
+    The writer fills getWriteBuffer() and calls publish(); the reader calls
+    read() and gets the most recently published value, complete and unchanged
+    until its next read(). Neither side ever waits for the other: the three
+    slots rotate through a single atomic exchange on each side, and values the
+    reader was too slow to see are simply skipped.
+*/
+template <typename Type>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    //==============================================================================
+    /** Writer: the slot to fill. It holds stale data, so write the whole value. */
+    Type& getWriteBuffer() noexcept                 { return buffers[(size_t) writeIndex]; }
+
+    /** Writer: makes the write buffer the newest value and takes a free slot for the next one. */
+    void publish() noexcept
+    {
+        const auto previous = middle.exchange (writeIndex | newDataFlag, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+
+    //==============================================================================
+    /** Reader: picks up the newest published value, if there is one, and returns it. */
+    const Type& read() noexcept
+    {
+        if ((middle.load (std::memory_order_relaxed) & newDataFlag) != 0)
+        {
+            const auto previous = middle.exchange (readIndex, std::memory_order_acq_rel);
+            readIndex = previous & indexMask;
+        }
+
+        return buffers[(size_t) readIndex];
+    }
+
+private:
+    // The middle slot's index, plus a flag saying the writer has put something new there
+    static constexpr int indexMask   = 3;
+    static constexpr int newDataFlag = 4;
+
+    std::array<Type, 3> buffers {};
+    std::atomic<int> middle { 1 };
+    int writeIndex = 0; // writer only
+    int readIndex  = 2; // reader only
+
+    static_assert (std::atomic<int>::is_always_lock_free, "The exchange must not take a lock");
+};
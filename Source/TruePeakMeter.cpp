@@ -0,0 +1,145 @@
+#include "TruePeakMeter.h"
+#include <cmath>
+
+namespace
+{
+    double besselI0 (double x) noexcept
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 32; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+
+        return sum;
+    }
+}
+
+//==============================================================================
+void TruePeakMeter::prepare (int numChannels, Oversampling oversampling)
+{
+    numPhases = (int) oversampling;
+    numGroups = (numChannels + (int) Vec::size() - 1) / (int) Vec::size();
+
+    // Kaiser-windowed sinc, numPhases * tapsPerPhase + 1 taps long and centred on
+    // a multiple of numPhases, so every phase but 0 lands between input samples
+    const double pi = 3.14159265358979323846;
+    const double beta = 5.0;
+    const int length = numPhases * tapsPerPhase;
+    const double centre = 0.5 * length;
+
+    coefficients.clear();
+
+    for (int phase = 1; phase < numPhases; ++phase)
+    {
+        double taps[tapsPerPhase];
+        double sum = 0.0;
+
+        for (int k = 0; k < tapsPerPhase; ++k)
+        {
+            const double n = (double) (phase + numPhases * k);
+            const double t = (n - centre) / numPhases;
+            const double sinc = std::sin (pi * t) / (pi * t);
+            const double r = (n - centre) / centre;
+            const double window = besselI0 (beta * std::sqrt (juce::jmax (0.0, 1.0 - r * r))) / besselI0 (beta);
+
+            taps[k] = sinc * window;
+            sum += taps[k];
+        }
+
+        // Unity DC gain per phase; tap k applies to the sample k steps back,
+        // so store them reversed to run over the history oldest first
+        for (int k = tapsPerPhase; --k >= 0;)
+            coefficients.push_back (Vec::expand ((float) (taps[k] / sum)));
+    }
+
+    history.assign ((size_t) (numGroups * tapsPerPhase * 2), Vec::expand (0.0f));
+    tile.assign ((size_t) tileLength, Vec::expand (0.0f));
+    reset();
+}
+
+void TruePeakMeter::reset() noexcept
+{
+    std::fill (history.begin(), history.end(), Vec::expand (0.0f));
+    writeIndex = 0;
+}
+
+template <typename SampleType>
+void TruePeakMeter::process (const SampleType* const* channels, int numChannels, int numSamples, float* blockPeaks) noexcept
+{
+    constexpr int lanes = (int) Vec::size();
+    jassert (numChannels <= numGroups * lanes);
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        const int firstChannel = group * lanes;
+        const int numLanes = juce::jmin (lanes, numChannels - firstChannel);
+
+        if (numLanes <= 0)
+            break;
+
+        auto* groupHistory = history.data() + group * tapsPerPhase * 2;
+        auto* tileValues = reinterpret_cast<float*> (tile.data());
+        int index = writeIndex;
+        auto peak = Vec::expand (0.0f);
+
+        for (int offset = 0; offset < numSamples; offset += tileLength)
+        {
+            const int length = juce::jmin (tileLength, numSamples - offset);
+
+            // Transpose the group's channels into the tile, one channel at a time
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                if (lane < numLanes)
+                {
+                    const auto* input = channels[firstChannel + lane] + offset;
+
+                    for (int i = 0; i < length; ++i)
+                        tileValues[i * lanes + lane] = (float) input[i];
+                }
+                else
+                {
+                    for (int i = 0; i < length; ++i)
+                        tileValues[i * lanes + lane] = 0.0f;
+                }
+            }
+
+            for (int i = 0; i < length; ++i)
+            {
+                const auto x = tile[(size_t) i];
+
+                groupHistory[index] = groupHistory[index + tapsPerPhase] = x;
+                index = (index + 1 == tapsPerPhase) ? 0 : index + 1;
+
+                // Phase 0 is the input itself
+                peak = Vec::max (peak, Vec::abs (x));
+
+                // The last tapsPerPhase samples, oldest first
+                const auto* window = groupHistory + index;
+                const auto* phaseCoefficients = coefficients.data();
+
+                for (int phase = 1; phase < numPhases; ++phase)
+                {
+                    auto sum = Vec::expand (0.0f);
+
+                    for (int k = 0; k < tapsPerPhase; ++k)
+                        sum = Vec::multiplyAdd (sum, phaseCoefficients[k], window[k]);
+
+                    peak = Vec::max (peak, Vec::abs (sum));
+                    phaseCoefficients += tapsPerPhase;
+                }
+            }
+        }
+
+        for (int lane = 0; lane < numLanes; ++lane)
+            blockPeaks[firstChannel + lane] = peak.get ((size_t) lane);
+    }
+
+    if (numGroups > 0)
+        writeIndex = (writeIndex + numSamples) % tapsPerPhase;
+}
+
+template void TruePeakMeter::process<float>  (const float* const*, int, int, float*) noexcept;
+template void TruePeakMeter::process<double> (const double* const*, int, int, float*) noexcept;
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <vector>
+
+//==============================================================================
+/**
+    True-peak level after ITU-R BS.1770-4 Annex 2: the signal is oversampled
+    4x (or 8x) and the largest absolute value of the oversampled signal is the
+    true peak, catching overs that fall between samples.
+
+    The interpolator is a polyphase windowed-sinc with its cutoff at the input
+    Nyquist frequency, so its phase 0 passes the input samples unchanged. Only
+    the in-between phases are computed; the samples themselves cover phase 0.
+    Channels are packed into SIMD lanes, so up to four channels cost the same
+    as one; each group of channels is transposed a tile at a time, so a whole
+    register is loaded per sample.
+*/
+class TruePeakMeter
+{
+public:
+    enum class Oversampling
+    {
+        fourTimes  = 4,
+        eightTimes = 8
+    };
+
+    TruePeakMeter() = default;
+
+    /** Allocates the filter state. Not realtime safe. */
+    void prepare (int numChannels, Oversampling oversampling);
+
+    void reset() noexcept;
+
+    /** Measures one block, writing each channel's true peak (linear, not held)
+        to blockPeaks. numChannels must not exceed what prepare() was given.
+        Double input is interpolated in float, which is plenty for a peak.
+    */
+    template <typename SampleType>
+    void process (const SampleType* const* channels, int numChannels, int numSamples, float* blockPeaks) noexcept;
+
+    /** The interpolator's delay in input samples; peaks are reported this late. */
+    static constexpr int getLatencySamples() noexcept       { return tapsPerPhase / 2; }
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    // 48 taps at 4x, as in the BS.1770 example filter
+    static constexpr int tapsPerPhase = 12;
+    static constexpr int tileLength = 128;
+
+    int numPhases = 4;
+    int numGroups = 0;
+
+    // Interpolated phases only (1 .. numPhases - 1), each tapsPerPhase long,
+    // ordered oldest sample first and pre-broadcast to all lanes
+    std::vector<Vec> coefficients;
+
+    // Per group of channels, each sample written twice, tapsPerPhase apart
+    std::vector<Vec> history;
+    int writeIndex = 0;
+
+    // tileLength samples of one group, each sample one register
+    std::vector<Vec> tile;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TruePeakMeter)
+};
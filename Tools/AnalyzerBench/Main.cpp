@@ -0,0 +1,288 @@
+// Microbenchmark for the analysis hot path. For every combination of FFT order,
+// sample rate and block size it feeds stereo noise through AnalysisEngine the way
+// processBlock does (pushBlock, then the analysis side draining the ring) and
+// reports the cost per sample and the number of FFT frames analysed per second.
+// With --fft it instead times the spectrum's FFT on every backend the build has
+// (see ComplexFFT), at orders 9 to 15 unless --orders says otherwise.
+//
+//   anime-analyzer-bench [--seconds <s>] [--orders 10,11,12] [--rates 44100,48000]
+//                        [--blocks 16,64,512] [--csv]
+//   anime-analyzer-bench --fft [--seconds <s>] [--orders 9,10,11] [--csv]
+
+#include "../../Source/AnalysisEngine.h"
+#include <iostream>
+#include <limits>
+
+namespace
+{
+    struct Result
+    {
+        double audioThreadNsPerSample = 0.0;
+        double totalNsPerSample = 0.0;
+        double framesPerSecond = 0.0;
+    };
+
+    Result runCase (int fftOrder, double sampleRate, int blockSize, const juce::AudioBuffer<float>& signal)
+    {
+        AnalysisEngine engine (fftOrder);
+
+        int numFrames = 0;
+        engine.onSpectrumFrame = [&numFrames] (const AnalysisFrame&) { ++numFrames; };
+        engine.prepare (sampleRate, blockSize);
+
+        const auto numSamples = signal.getNumSamples();
+        const auto* const* channels = signal.getArrayOfReadPointers();
+        const float* blockChannels[2];
+
+        juce::int64 pushTicks = 0;
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        for (int position = 0; position + blockSize <= numSamples; position += blockSize)
+        {
+            blockChannels[0] = channels[0] + position;
+            blockChannels[1] = channels[1] + position;
+
+            const auto pushStart = juce::Time::getHighResolutionTicks();
+            engine.pushBlock (blockChannels, 2, blockSize);
+            pushTicks += juce::Time::getHighResolutionTicks() - pushStart;
+
+            engine.processPendingSamples();
+        }
+
+        const auto totalSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+        const auto numProcessed = (double) (numSamples - numSamples % blockSize);
+
+        Result result;
+
+        // A block longer than the whole signal processes nothing
+        if (numProcessed <= 0.0)
+            return result;
+
+        result.audioThreadNsPerSample = juce::Time::highResolutionTicksToSeconds (pushTicks) * 1.0e9 / numProcessed;
+        result.totalNsPerSample       = totalSeconds * 1.0e9 / numProcessed;
+        result.framesPerSecond        = totalSeconds > 0.0 ? numFrames / totalSeconds : 0.0;
+        return result;
+    }
+
+    struct FftResult
+    {
+        double nsPerTransform = 0.0;
+        double maxError = 0.0; // against the juce backend, relative to its largest bin
+    };
+
+    FftResult runFftCase (ComplexFFT::Backend backend, int order, double seconds, juce::Random& random)
+    {
+        ComplexFFT fft (order, backend);
+        ComplexFFT reference (order, ComplexFFT::Backend::juce);
+
+        for (int i = 0; i < fft.getSize(); ++i)
+        {
+            fft.getInput()[i] = { random.nextFloat() * 2.0f - 1.0f, random.nextFloat() * 2.0f - 1.0f };
+            reference.getInput()[i] = fft.getInput()[i];
+        }
+
+        fft.perform();
+        reference.perform();
+
+        float largest = 0.0f, maxDifference = 0.0f;
+
+        for (int i = 0; i < fft.getSize(); ++i)
+        {
+            largest = juce::jmax (largest, std::abs (reference.getOutput()[i]));
+            maxDifference = juce::jmax (maxDifference, std::abs (fft.getOutput()[i] - reference.getOutput()[i]));
+        }
+
+        // Batches long enough for the clock, until the time is up
+        const auto batchSize = juce::jmax (1, (1 << 20) >> order);
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        juce::int64 numTransforms = 0;
+        double elapsed = 0.0;
+
+        do
+        {
+            for (int i = 0; i < batchSize; ++i)
+                fft.perform();
+
+            numTransforms += batchSize;
+            elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+        }
+        while (elapsed < seconds);
+
+        FftResult result;
+        result.nsPerTransform = elapsed * 1.0e9 / (double) numTransforms;
+        result.maxError = largest > 0.0f ? maxDifference / largest : 0.0;
+        return result;
+    }
+
+    int runFftBenchmark (const juce::Array<int>& orders, double seconds, bool csv)
+    {
+        if (csv)
+            std::cout << "fft_order,fft_size,backend,ns_per_transform,mflops,speedup_vs_juce,max_error_vs_juce" << std::endl;
+        else
+            std::cout << "order    size  backend       ns/fft     mflops  vs juce   max error" << std::endl;
+
+        juce::Random random (0x414e494d);
+
+        for (auto order : orders)
+        {
+            double juceNs = 0.0;
+
+            for (auto backend : { ComplexFFT::Backend::juce, ComplexFFT::Backend::pffft })
+            {
+                if (! ComplexFFT::isAvailable (backend))
+                    continue;
+
+                const auto r = runFftCase (backend, order, seconds, random);
+
+                if (backend == ComplexFFT::Backend::juce)
+                    juceNs = r.nsPerTransform;
+
+                // The usual 5 N log2 N flop count for a complex FFT
+                const auto size = 1 << order;
+                const auto mflops = 5.0 * size * order / r.nsPerTransform * 1.0e3;
+                const auto speedup = juceNs / r.nsPerTransform;
+
+                if (csv)
+                {
+                    std::cout << order << "," << size << "," << ComplexFFT::getBackendName (backend) << ","
+                              << r.nsPerTransform << "," << mflops << "," << speedup << "," << r.maxError << std::endl;
+                }
+                else
+                {
+                    std::cout << juce::String (order).paddedLeft (' ', 5)
+                              << juce::String (size).paddedLeft (' ', 8)
+                              << "  " << juce::String (ComplexFFT::getBackendName (backend)).paddedRight (' ', 7)
+                              << juce::String (r.nsPerTransform, 0).paddedLeft (' ', 12)
+                              << juce::String (mflops, 0).paddedLeft (' ', 11)
+                              << juce::String (speedup, 2).paddedLeft (' ', 9)
+                              << juce::String (r.maxError, 8).paddedLeft (' ', 12) << std::endl;
+                }
+            }
+        }
+
+        return 0;
+    }
+
+    juce::Array<int> parseList (const juce::String& text)
+    {
+        juce::Array<int> values;
+
+        for (auto& token : juce::StringArray::fromTokens (text, ",", {}))
+            if (token.trim().isNotEmpty())
+                values.add (token.trim().getIntValue());
+
+        return values;
+    }
+
+    bool isListWithin (const juce::Array<int>& values, int minValue, int maxValue)
+    {
+        if (values.isEmpty())
+            return false;
+
+        for (auto v : values)
+            if (v < minValue || v > maxValue)
+                return false;
+
+        return true;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    double seconds = 2.0;
+    juce::Array<int> orders { 10, 11, 12, 13 };
+    juce::Array<int> sampleRates { 44100, 48000, 96000, 192000, 384000 };
+    juce::Array<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+
+    if (args.containsOption ("--seconds"))
+        seconds = juce::jlimit (0.1, 600.0, args.getValueForOption ("--seconds").getDoubleValue());
+
+    if (args.containsOption ("--orders"))
+        orders = parseList (args.getValueForOption ("--orders"));
+
+    if (args.containsOption ("--rates"))
+        sampleRates = parseList (args.getValueForOption ("--rates"));
+
+    if (args.containsOption ("--blocks"))
+        blockSizes = parseList (args.getValueForOption ("--blocks"));
+
+    const bool csv = args.containsOption ("--csv");
+
+    if (args.containsOption ("--fft"))
+    {
+        if (! args.containsOption ("--orders"))
+            orders = { 9, 10, 11, 12, 13, 14, 15 };
+
+        if (! isListWithin (orders, 4, 20))
+        {
+            std::cerr << "fft orders must be 4 to 20" << std::endl;
+            return 1;
+        }
+
+        return runFftBenchmark (orders, seconds, csv);
+    }
+
+    // The engine would clamp any other order, and the table would claim the wrong one
+    if (! isListWithin (orders, AnalysisEngine::minFftOrder, AnalysisEngine::maxFftOrder))
+    {
+        std::cerr << "fft orders must be " << AnalysisEngine::minFftOrder << " to " << AnalysisEngine::maxFftOrder << std::endl;
+        return 1;
+    }
+
+    if (! isListWithin (sampleRates, 1, std::numeric_limits<int>::max()))
+    {
+        std::cerr << "sample rates must be positive" << std::endl;
+        return 1;
+    }
+
+    if (! isListWithin (blockSizes, 1, std::numeric_limits<int>::max()))
+    {
+        std::cerr << "block sizes must be positive" << std::endl;
+        return 1;
+    }
+
+    if (csv)
+        std::cout << "fft_order,sample_rate,block_size,audio_thread_ns_per_sample,total_ns_per_sample,frames_per_second" << std::endl;
+    else
+        std::cout << "order    rate  block   audio ns/smp   total ns/smp     frames/s" << std::endl;
+
+    juce::Random random (0x414e494d);
+
+    for (auto sampleRate : sampleRates)
+    {
+        // Uncorrelated noise per channel, so nothing in the kernel can short-circuit
+        juce::AudioBuffer<float> signal (2, juce::roundToInt (sampleRate * seconds));
+
+        for (int ch = 0; ch < signal.getNumChannels(); ++ch)
+            for (int i = 0; i < signal.getNumSamples(); ++i)
+                signal.setSample (ch, i, random.nextFloat() * 2.0f - 1.0f);
+
+        for (auto order : orders)
+        {
+            for (auto blockSize : blockSizes)
+            {
+                const auto r = runCase (order, (double) sampleRate, blockSize, signal);
+
+                if (csv)
+                {
+                    std::cout << order << "," << sampleRate << "," << blockSize << ","
+                              << r.audioThreadNsPerSample << "," << r.totalNsPerSample << "," << r.framesPerSecond << std::endl;
+                }
+                else
+                {
+                    std::cout << juce::String (order).paddedLeft (' ', 5)
+                              << juce::String (sampleRate).paddedLeft (' ', 8)
+                              << juce::String (blockSize).paddedLeft (' ', 7)
+                              << juce::String (r.audioThreadNsPerSample, 2).paddedLeft (' ', 15)
+                              << juce::String (r.totalNsPerSample, 2).paddedLeft (' ', 15)
+                              << juce::String (r.framesPerSecond, 0).paddedLeft (' ', 13) << std::endl;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,519 @@
+// Offline batch analyzer: runs the plugin's AnalysisEngine over a list of audio
+// files and writes per-file summaries plus per-frame band data.
+//
+//   anime-analyzer-batch [options] <file-or-folder>...
+//
+//   --output <dir>         where to write the report (default: ./anime-analyzer-report)
+//   --format csv|json|both report format (default: csv)
+//   --threads <n>          files analysed in parallel (default: number of CPU cores)
+//   --block-size <n>       samples read and processed per block (default: 65536)
+//   --overlap 50|75|87.5   FFT frame overlap (default: 50)
+//   --analyzer fft|filterbank  where the band levels come from (default: fft)
+//   --no-frames            only write the summary, not the per-frame band data
+
+#include "../../Source/AnalysisEngine.h"
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    //==============================================================================
+    struct Options
+    {
+        juce::File outputDirectory;
+        bool writeCsv = true;
+        bool writeJson = false;
+        bool writeFrames = true;
+        int numThreads = juce::SystemStats::getNumCpus();
+        int blockSize = 65536;
+        AnalysisEngine::Overlap overlap = AnalysisEngine::Overlap::half;
+        AnalysisEngine::Analyzer analyzer = AnalysisEngine::Analyzer::fft;
+    };
+
+    struct FileSummary
+    {
+        juce::File file;
+        juce::String error;
+
+        double sampleRate = 0.0;
+        int numChannels = 0;
+        juce::int64 numSamples = 0;
+
+        // Per channel, in the file's order; the CSV has the first two
+        using ChannelValues = std::array<double, AnalysisEngine::maxChannels>;
+        ChannelValues rmsDb, peakDb, truePeakDb;
+        std::array<double, AnalysisFrame::maxCorrelationPairs> correlations {};
+        int numCorrelationPairs = 0;
+        double integratedLoudness = -100.0;
+        double loudnessRange = 0.0;
+        std::array<double, AnalysisEngine::maxSpectrumBands> meanBandLevels {};
+        std::array<double, AnalysisEngine::maxSpectrumBands> longTermAverageBandLevels {};
+        int numFrames = 0;
+
+        double processingSeconds = 0.0;
+
+        FileSummary (const juce::File& f = {}) : file (f)
+        {
+            rmsDb.fill (-100.0);
+            peakDb.fill (-100.0);
+            truePeakDb.fill (-100.0);
+        }
+
+        double getRealtimeFactor() const
+        {
+            return processingSeconds > 0.0 ? ((double) numSamples / sampleRate) / processingSeconds : 0.0;
+        }
+    };
+
+    //==============================================================================
+    juce::String formatNumber (double value, int decimals = 3)
+    {
+        return std::isfinite (value) ? juce::String (value, decimals) : juce::String ("null");
+    }
+
+    juce::String getFrameFileName (const FileSummary& summary, const juce::String& extension)
+    {
+        return summary.file.getFileNameWithoutExtension() + "."
+             + juce::String::toHexString (summary.file.getFullPathName().hashCode()) + ".frames" + extension;
+    }
+
+    //==============================================================================
+    /** Streams per-frame band levels to disk as they are produced. */
+    class FrameWriter
+    {
+    public:
+        FrameWriter (const Options& options, const FileSummary& summary)
+        {
+            if (! options.writeFrames)
+                return;
+
+            if (options.writeCsv)
+            {
+                csv = openStream (options.outputDirectory.getChildFile (getFrameFileName (summary, ".csv")));
+
+                if (csv != nullptr)
+                {
+                    *csv << "time_seconds";
+
+                    for (int band = 0; band < AnalysisEngine::maxSpectrumBands; ++band)
+                        *csv << "," << formatNumber (AnalysisEngine::getSpectrumBandCentreFrequency (band), 1) << "Hz";
+
+                    *csv << "\n";
+                }
+            }
+
+            if (options.writeJson)
+            {
+                json = openStream (options.outputDirectory.getChildFile (getFrameFileName (summary, ".json")));
+
+                if (json != nullptr)
+                    *json << "[\n";
+            }
+        }
+
+        ~FrameWriter()
+        {
+            if (json != nullptr)
+                *json << "\n]\n";
+        }
+
+        void write (double timeSeconds, const float* bandLevels, int numBands)
+        {
+            if (csv != nullptr)
+            {
+                *csv << formatNumber (timeSeconds, 6);
+
+                for (int band = 0; band < numBands; ++band)
+                    *csv << "," << formatNumber (bandLevels[band], 5);
+
+                *csv << "\n";
+            }
+
+            if (json != nullptr)
+            {
+                *json << (firstJsonFrame ? "  " : ",\n  ") << "{ \"time\": " << formatNumber (timeSeconds, 6) << ", \"bands\": [";
+
+                for (int band = 0; band < numBands; ++band)
+                    *json << (band > 0 ? ", " : "") << formatNumber (bandLevels[band], 5);
+
+                *json << "] }";
+                firstJsonFrame = false;
+            }
+        }
+
+    private:
+        static std::unique_ptr<juce::FileOutputStream> openStream (const juce::File& file)
+        {
+            auto stream = std::make_unique<juce::FileOutputStream> (file, 1 << 16);
+
+            if (! stream->openedOk())
+                return nullptr;
+
+            stream->setPosition (0);
+            stream->truncate();
+            return stream;
+        }
+
+        std::unique_ptr<juce::FileOutputStream> csv, json;
+        bool firstJsonFrame = true;
+    };
+
+    //==============================================================================
+    void analyseFile (juce::AudioFormatManager& formatManager, const Options& options, FileSummary& summary)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (summary.file));
+
+        if (reader == nullptr)
+        {
+            summary.error = "unsupported or unreadable file";
+            return;
+        }
+
+        summary.sampleRate  = reader->sampleRate;
+        summary.numChannels = (int) reader->numChannels;
+        summary.numSamples  = reader->lengthInSamples;
+
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        const int numChannels = juce::jlimit (1, AnalysisEngine::maxChannels, (int) reader->numChannels);
+        juce::AudioBuffer<float> buffer (numChannels, options.blockSize);
+
+        auto layout = reader->getChannelLayout();
+
+        if (layout.size() != numChannels)
+            layout = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+
+        FrameWriter frameWriter (options, summary);
+
+        AnalysisEngine engine;
+        engine.setChannelLayout (layout);
+        engine.setOverlap (options.overlap);
+
+        auto settings = engine.getSpectrumSettings();
+        settings.analyzer = options.analyzer;
+        engine.setSpectrumSettings (settings);
+
+        engine.onSpectrumFrame = [&] (const AnalysisFrame& frame)
+        {
+            const auto& bandLevels = frame.spectrumBandLevels[(size_t) AnalysisEngine::SpectrumView::mid];
+            frameWriter.write ((double) frame.samplePosition / summary.sampleRate, bandLevels.data(), (int) bandLevels.size());
+
+            for (size_t band = 0; band < bandLevels.size(); ++band)
+                summary.meanBandLevels[band] += bandLevels[band];
+
+            ++summary.numFrames;
+        };
+
+        engine.prepare (summary.sampleRate, options.blockSize);
+
+        std::array<double, AnalysisEngine::maxChannels> sumSquares {};
+        std::array<float, AnalysisEngine::maxChannels> peak {}, truePeak {};
+        std::array<double, AnalysisFrame::maxCorrelationPairs> weightedCorrelations {};
+
+        for (juce::int64 position = 0; position < summary.numSamples; position += options.blockSize)
+        {
+            const auto numSamples = (int) juce::jmin ((juce::int64) options.blockSize, summary.numSamples - position);
+
+            buffer.setSize (numChannels, numSamples, false, false, true);
+            reader->read (&buffer, 0, numSamples, position, true, true);
+
+            engine.pushBlock (buffer.getArrayOfReadPointers(), numChannels, numSamples);
+            engine.processPendingSamples();
+
+            // Analysing synchronously, each block gets its own frame with its own meters
+            const auto& frame = engine.getLatestFrame();
+
+            for (size_t ch = 0; ch < (size_t) numChannels; ++ch)
+            {
+                const auto rms = (double) frame.getRmsLevel ((int) ch);
+                sumSquares[ch] += rms * rms * frame.numMeteredSamples;
+                peak[ch] = juce::jmax (peak[ch], frame.getPeakLevel ((int) ch));
+                truePeak[ch] = juce::jmax (truePeak[ch], frame.getTruePeakLevel ((int) ch));
+            }
+
+            for (int pair = 0; pair < frame.numCorrelationPairs; ++pair)
+                weightedCorrelations[(size_t) pair] += (double) frame.getCorrelation (pair) * frame.numMeteredSamples;
+        }
+
+        for (size_t ch = 0; ch < (size_t) numChannels; ++ch)
+        {
+            summary.rmsDb[ch]  = juce::Decibels::gainToDecibels (std::sqrt (sumSquares[ch] / (double) juce::jmax ((juce::int64) 1, summary.numSamples)), -100.0);
+            summary.peakDb[ch] = juce::Decibels::gainToDecibels ((double) peak[ch], -100.0);
+            summary.truePeakDb[ch] = juce::Decibels::gainToDecibels ((double) truePeak[ch], -100.0);
+        }
+
+        summary.numCorrelationPairs = engine.getLatestFrame().numCorrelationPairs;
+
+        for (size_t pair = 0; pair < weightedCorrelations.size(); ++pair)
+            summary.correlations[pair] = weightedCorrelations[pair] / (double) juce::jmax ((juce::int64) 1, summary.numSamples);
+
+        const auto& lastFrame = engine.getLatestFrame();
+        summary.integratedLoudness = lastFrame.integratedLoudness;
+        summary.loudnessRange = lastFrame.loudnessRange;
+
+        // The engine's long-term average covers the whole file, as power rather than
+        // as a mean of the smoothed display levels
+        for (int band = 0; band < AnalysisEngine::maxSpectrumBands; ++band)
+            summary.longTermAverageBandLevels[(size_t) band] = lastFrame.getAverageBandLevel (band);
+
+        for (auto& level : summary.meanBandLevels)
+            level /= (double) juce::jmax (1, summary.numFrames);
+
+        summary.processingSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    //==============================================================================
+    void writeCsvSummary (const juce::File& file, const std::vector<FileSummary>& summaries)
+    {
+        juce::FileOutputStream out (file);
+
+        if (! out.openedOk())
+            return;
+
+        out.setPosition (0);
+        out.truncate();
+
+        out << "file,error,sample_rate,channels,duration_seconds,rms_left_db,rms_right_db,peak_left_db,peak_right_db,true_peak_left_dbtp,true_peak_right_dbtp,integrated_lufs,loudness_range_lu,correlation,frames,realtime_factor";
+
+        for (int band = 0; band < AnalysisEngine::maxSpectrumBands; ++band)
+            out << ",mean_" << formatNumber (AnalysisEngine::getSpectrumBandCentreFrequency (band), 1) << "Hz";
+
+        for (int band = 0; band < AnalysisEngine::maxSpectrumBands; ++band)
+            out << ",ltas_" << formatNumber (AnalysisEngine::getSpectrumBandCentreFrequency (band), 1) << "Hz";
+
+        out << "\n";
+
+        for (auto& s : summaries)
+        {
+            out << s.file.getFullPathName().quoted() << "," << s.error.quoted() << ","
+                << formatNumber (s.sampleRate, 0) << "," << s.numChannels << ","
+                << formatNumber (s.sampleRate > 0.0 ? (double) s.numSamples / s.sampleRate : 0.0) << ","
+                << formatNumber (s.rmsDb[0]) << "," << formatNumber (s.rmsDb[1]) << ","
+                << formatNumber (s.peakDb[0]) << "," << formatNumber (s.peakDb[1]) << ","
+                << formatNumber (s.truePeakDb[0]) << "," << formatNumber (s.truePeakDb[1]) << ","
+                << formatNumber (s.integratedLoudness) << "," << formatNumber (s.loudnessRange) << ","
+                << formatNumber (s.correlations[0], 4) << "," << s.numFrames << ","
+                << formatNumber (s.getRealtimeFactor(), 1);
+
+            for (auto level : s.meanBandLevels)
+                out << "," << formatNumber (level, 5);
+
+            for (auto level : s.longTermAverageBandLevels)
+                out << "," << formatNumber (level, 5);
+
+            out << "\n";
+        }
+    }
+
+    void writeJsonSummary (const juce::File& file, const std::vector<FileSummary>& summaries)
+    {
+        juce::Array<juce::var> files;
+
+        for (auto& s : summaries)
+        {
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty ("file", s.file.getFullPathName());
+
+            if (s.error.isNotEmpty())
+            {
+                entry->setProperty ("error", s.error);
+            }
+            else
+            {
+                juce::Array<juce::var> rms, peak, truePeak, correlations, bands, longTermAverage;
+
+                for (size_t ch = 0; ch < (size_t) juce::jmin (AnalysisEngine::maxChannels, s.numChannels); ++ch)
+                {
+                    rms.add (s.rmsDb[ch]);
+                    peak.add (s.peakDb[ch]);
+                    truePeak.add (s.truePeakDb[ch]);
+                }
+
+                for (size_t pair = 0; pair < (size_t) s.numCorrelationPairs; ++pair)
+                    correlations.add (s.correlations[pair]);
+
+                for (auto level : s.meanBandLevels)
+                    bands.add (level);
+
+                for (auto level : s.longTermAverageBandLevels)
+                    longTermAverage.add (level);
+
+                entry->setProperty ("sampleRate", s.sampleRate);
+                entry->setProperty ("channels", s.numChannels);
+                entry->setProperty ("durationSeconds", (double) s.numSamples / s.sampleRate);
+                entry->setProperty ("rmsDb", rms);
+                entry->setProperty ("peakDb", peak);
+                entry->setProperty ("truePeakDbtp", truePeak);
+                entry->setProperty ("integratedLufs", s.integratedLoudness);
+                entry->setProperty ("loudnessRangeLu", s.loudnessRange);
+                entry->setProperty ("correlation", s.correlations[0]);
+                entry->setProperty ("correlations", correlations);
+                entry->setProperty ("frames", s.numFrames);
+                entry->setProperty ("meanBandLevels", bands);
+                entry->setProperty ("longTermAverageBandLevels", longTermAverage);
+                entry->setProperty ("realtimeFactor", s.getRealtimeFactor());
+            }
+
+            files.add (juce::var (entry));
+        }
+
+        file.replaceWithText (juce::JSON::toString (juce::var (files)));
+    }
+
+    //==============================================================================
+    void printUsage()
+    {
+        std::cout << "usage: anime-analyzer-batch [--output <dir>] [--format csv|json|both] [--threads <n>]\n"
+                     "                            [--block-size <n>] [--overlap 50|75|87.5] [--analyzer fft|filterbank]\n"
+                     "                            [--no-frames]\n"
+                     "                            <file-or-folder>..." << std::endl;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.size() == 0 || args.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return args.size() == 0 ? 1 : 0;
+    }
+
+    Options options;
+    options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile ("anime-analyzer-report");
+
+    if (args.containsOption ("--output"))
+        options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile (args.removeValueForOption ("--output"));
+
+    if (args.containsOption ("--format"))
+    {
+        const auto format = args.removeValueForOption ("--format");
+        options.writeCsv  = format == "csv"  || format == "both";
+        options.writeJson = format == "json" || format == "both";
+
+        if (! (options.writeCsv || options.writeJson))
+        {
+            std::cerr << "unknown format: " << format << std::endl;
+            return 1;
+        }
+    }
+
+    if (args.containsOption ("--threads"))
+        options.numThreads = juce::jmax (1, args.removeValueForOption ("--threads").getIntValue());
+
+    if (args.containsOption ("--block-size"))
+        options.blockSize = juce::jlimit (64, 1 << 20, args.removeValueForOption ("--block-size").getIntValue());
+
+    if (args.containsOption ("--overlap"))
+    {
+        const auto overlap = args.removeValueForOption ("--overlap");
+
+        if (overlap == "75")
+            options.overlap = AnalysisEngine::Overlap::threeQuarters;
+        else if (overlap == "87.5")
+            options.overlap = AnalysisEngine::Overlap::sevenEighths;
+        else if (overlap != "50")
+        {
+            std::cerr << "overlap must be 50, 75 or 87.5" << std::endl;
+            return 1;
+        }
+    }
+
+    if (args.containsOption ("--analyzer"))
+    {
+        const auto analyzer = args.removeValueForOption ("--analyzer");
+
+        if (analyzer == "filterbank")
+            options.analyzer = AnalysisEngine::Analyzer::filterBank;
+        else if (analyzer != "fft")
+        {
+            std::cerr << "analyzer must be fft or filterbank" << std::endl;
+            return 1;
+        }
+    }
+
+    if (args.removeOptionIfFound ("--no-frames"))
+        options.writeFrames = false;
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    const auto wildcard = formatManager.getWildcardForAllFormats();
+    std::vector<FileSummary> summaries;
+
+    for (auto& arg : args.arguments)
+    {
+        const auto file = arg.resolveAsFile();
+
+        if (file.isDirectory())
+        {
+            for (const auto& entry : juce::RangedDirectoryIterator (file, true, wildcard, juce::File::findFiles))
+                summaries.push_back ({ entry.getFile() });
+        }
+        else if (file.existsAsFile())
+        {
+            summaries.push_back ({ file });
+        }
+        else
+        {
+            std::cerr << "skipping missing input: " << arg.text << std::endl;
+        }
+    }
+
+    if (summaries.empty())
+    {
+        std::cerr << "no input files" << std::endl;
+        return 1;
+    }
+
+    if (! options.outputDirectory.createDirectory())
+    {
+        std::cerr << "cannot create output directory: " << options.outputDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    {
+        juce::ThreadPool pool (juce::jmin (options.numThreads, (int) summaries.size()));
+
+        for (auto& summary : summaries)
+            pool.addJob ([&formatManager, &options, &summary] { analyseFile (formatManager, options, summary); });
+
+        while (pool.getNumJobs() > 0)
+            juce::Thread::sleep (20);
+    }
+
+    const auto elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+    if (options.writeCsv)
+        writeCsvSummary (options.outputDirectory.getChildFile ("summary.csv"), summaries);
+
+    if (options.writeJson)
+        writeJsonSummary (options.outputDirectory.getChildFile ("summary.json"), summaries);
+
+    double audioSeconds = 0.0;
+    int numFailed = 0;
+
+    for (auto& s : summaries)
+    {
+        if (s.error.isNotEmpty())
+        {
+            std::cerr << s.file.getFullPathName() << ": " << s.error << std::endl;
+            ++numFailed;
+        }
+        else
+        {
+            audioSeconds += (double) s.numSamples / s.sampleRate;
+        }
+    }
+
+    std::cout << "analysed " << (summaries.size() - (size_t) numFailed) << " file(s), "
+              << juce::String (audioSeconds, 1) << " s of audio in " << juce::String (elapsed, 2) << " s ("
+              << juce::String (elapsed > 0.0 ? audioSeconds / elapsed : 0.0, 1) << "x realtime)" << std::endl;
+
+    return numFailed > 0 ? 2 : 0;
+}
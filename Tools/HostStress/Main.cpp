@@ -0,0 +1,540 @@
+// Host simulation stress test: runs a session of plugin instances the way a busy
+// host does (one audio thread, jittery callbacks, block sizes from one sample
+// upwards, prepareToPlay again mid-stream) at several sample rates, reports the
+// distribution of processBlock times, counts allocations and locks made inside
+// processBlock, and fails if any of the budgets below is exceeded.
+//
+//   anime-analyzer-host-stress [options]
+//
+//   --instances <n>        plugin instances in the session (default: 8)
+//   --seconds <s>          audio simulated per sample rate (default: 5)
+//   --rates <list>         sample rates to run at (default: 44100,48000,88200,96000)
+//   --block <n>            the host's usual block size (default: 256)
+//   --max-block <n>        the block size prepareToPlay announces, and the largest used (default: 2048)
+//   --double               process 64-bit buffers
+//   --reprepare <n>        one cycle in n (on average) prepares an instance again mid-stream (default: 200)
+//   --jitter-ms <ms>       random lateness added to each callback (default: 1)
+//   --unpaced              run cycles back to back instead of in real time
+//   --seed <n>             block size and jitter sequence (default: fixed)
+//
+// Budgets; the exit code is 1 if any is exceeded:
+//
+//   --p99-us <us>          99th percentile processBlock time (default: 100)
+//   --max-us <us>          slowest processBlock (default: 1000)
+//   --max-load <x>         slowest cycle through every instance, as a share of its block's
+//                          duration; blocks under 64 samples are left out (default: 0.5)
+//   --allocations <n>      heap allocations and frees inside processBlock (default: 0)
+//   --locks <n>            mutex locks inside processBlock (default: 0)
+//
+// Allocations are counted by interposing malloc and its aligned variants on glibc,
+// and operator new (aligned or not) elsewhere; locks by interposing
+// pthread_mutex_lock/trylock, on Linux only.
+
+#include "../../Source/PluginProcessor.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#if JUCE_WINDOWS
+ #include <malloc.h>
+#endif
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+#endif
+
+namespace
+{
+    //==============================================================================
+    // Set around each processBlock call; the interposers below only count while it is
+    thread_local bool insideCallback = false;
+
+    std::atomic<juce::int64> callbackAllocations { 0 };
+    std::atomic<juce::int64> callbackLocks { 0 };
+
+    inline void noteAllocation() noexcept
+    {
+        if (insideCallback)
+            callbackAllocations.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    inline void noteLock() noexcept
+    {
+        if (insideCallback)
+            callbackLocks.fetch_add (1, std::memory_order_relaxed);
+    }
+
+   #if JUCE_LINUX
+    template <typename Function>
+    Function* findNext (std::atomic<Function*>& cached, const char* name) noexcept
+    {
+        // Racing lookups find the same symbol, so there's nothing to guard
+        auto* function = cached.load (std::memory_order_acquire);
+
+        if (function == nullptr)
+        {
+            function = reinterpret_cast<Function*> (dlsym (RTLD_NEXT, name));
+            cached.store (function, std::memory_order_release);
+        }
+
+        return function;
+    }
+   #endif
+
+    constexpr bool tracksLocks =
+       #if JUCE_LINUX
+        true;
+       #else
+        false;
+       #endif
+}
+
+//==============================================================================
+#if defined (__GLIBC__)
+extern "C"
+{
+    void* __libc_malloc (size_t) noexcept;
+    void* __libc_calloc (size_t, size_t) noexcept;
+    void* __libc_realloc (void*, size_t) noexcept;
+    void* __libc_memalign (size_t, size_t) noexcept;
+    void  __libc_free (void*) noexcept;
+
+    // operator new and delete come through here too, the aligned ones via aligned_alloc
+    void* malloc (size_t size) noexcept                          { noteAllocation(); return __libc_malloc (size); }
+    void* calloc (size_t count, size_t size) noexcept            { noteAllocation(); return __libc_calloc (count, size); }
+    void* realloc (void* block, size_t size) noexcept            { noteAllocation(); return __libc_realloc (block, size); }
+    void* memalign (size_t alignment, size_t size) noexcept      { noteAllocation(); return __libc_memalign (alignment, size); }
+    void* aligned_alloc (size_t alignment, size_t size) noexcept { noteAllocation(); return __libc_memalign (alignment, size); }
+
+    int posix_memalign (void** result, size_t alignment, size_t size) noexcept
+    {
+        noteAllocation();
+
+        if (alignment % sizeof (void*) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        auto* block = __libc_memalign (alignment, size);
+
+        if (block == nullptr)
+            return ENOMEM;
+
+        *result = block;
+        return 0;
+    }
+
+    void free (void* block) noexcept
+    {
+        if (block != nullptr)
+            noteAllocation();
+
+        __libc_free (block);
+    }
+}
+#else
+void* operator new (size_t size)
+{
+    noteAllocation();
+
+    if (auto* block = std::malloc (size == 0 ? 1 : size))
+        return block;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size)                  { return operator new (size); }
+
+void operator delete (void* block) noexcept
+{
+    if (block != nullptr)
+        noteAllocation();
+
+    std::free (block);
+}
+
+void operator delete[] (void* block) noexcept       { operator delete (block); }
+void operator delete (void* block, size_t) noexcept     { operator delete (block); }
+void operator delete[] (void* block, size_t) noexcept   { operator delete (block); }
+
+// Over-aligned types (SIMD registers, say) go through these instead
+void* operator new (size_t size, std::align_val_t alignment)
+{
+    noteAllocation();
+
+   #if JUCE_WINDOWS
+    if (auto* block = _aligned_malloc (size == 0 ? 1 : size, (size_t) alignment))
+        return block;
+   #else
+    void* block = nullptr;
+
+    if (posix_memalign (&block, std::max ((size_t) alignment, sizeof (void*)), size == 0 ? 1 : size) == 0)
+        return block;
+   #endif
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size, std::align_val_t alignment)      { return operator new (size, alignment); }
+
+void operator delete (void* block, std::align_val_t) noexcept
+{
+    if (block != nullptr)
+        noteAllocation();
+
+   #if JUCE_WINDOWS
+    _aligned_free (block);
+   #else
+    std::free (block);
+   #endif
+}
+
+void operator delete[] (void* block, std::align_val_t alignment) noexcept           { operator delete (block, alignment); }
+void operator delete (void* block, size_t, std::align_val_t alignment) noexcept     { operator delete (block, alignment); }
+void operator delete[] (void* block, size_t, std::align_val_t alignment) noexcept   { operator delete (block, alignment); }
+#endif
+
+#if JUCE_LINUX
+extern "C"
+{
+    int pthread_mutex_lock (pthread_mutex_t* mutex) noexcept
+    {
+        static std::atomic<int (*) (pthread_mutex_t*)> next { nullptr };
+        noteLock();
+        return findNext (next, "pthread_mutex_lock") (mutex);
+    }
+
+    int pthread_mutex_trylock (pthread_mutex_t* mutex) noexcept
+    {
+        static std::atomic<int (*) (pthread_mutex_t*)> next { nullptr };
+        noteLock();
+        return findNext (next, "pthread_mutex_trylock") (mutex);
+    }
+}
+#endif
+
+namespace
+{
+    //==============================================================================
+    struct Options
+    {
+        int numInstances = 8;
+        double seconds = 5.0;
+        juce::Array<int> sampleRates { 44100, 48000, 88200, 96000 };
+        int blockSize = 256;
+        int maxBlockSize = 2048;
+        bool doublePrecision = false;
+        int reprepareOneIn = 200;
+        double jitterMs = 1.0;
+        bool paced = true;
+        juce::int64 seed = 0x414e494d;
+
+        double p99BudgetMicros = 100.0;
+        double maxBudgetMicros = 1000.0;
+        double maxLoadBudget = 0.5;
+        juce::int64 allocationBudget = 0;
+        juce::int64 lockBudget = 0;
+    };
+
+    // Cycles shorter than this are all fixed overhead; they only count towards the per-call budgets
+    constexpr int minLoadBlockSize = 64;
+
+    struct PassResult
+    {
+        std::vector<double> callbackMicros;
+        double maxCycleLoad = 0.0;
+        int slowestBlockSize = 0;
+        juce::int64 numCycles = 0, numReprepares = 0;
+        double maxPrepareMillis = 0.0;
+        juce::int64 allocations = 0, locks = 0;
+
+        double getPercentile (double p) const
+        {
+            if (callbackMicros.empty())
+                return 0.0;
+
+            return callbackMicros[(size_t) (p * (double) (callbackMicros.size() - 1))];
+        }
+    };
+
+    //==============================================================================
+    /** Mostly the usual size, with the odd ones real hosts send around loop points,
+        automation splits and offline bounces.
+    */
+    int pickBlockSize (juce::Random& random, const Options& options)
+    {
+        switch (random.nextInt (8))
+        {
+            case 0:  return 1;
+            case 1:  return 1 + 2 * random.nextInt (juce::jmax (1, options.blockSize / 2));
+            case 2:  return 1 + random.nextInt (options.maxBlockSize);
+            case 3:  return options.maxBlockSize;
+            default: return options.blockSize;
+        }
+    }
+
+    double ticksToMicros (juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds (ticks) * 1.0e6;
+    }
+
+    void prepare (juce::AudioProcessor& processor, double sampleRate, int maxBlockSize)
+    {
+        // What the plugin wrappers do before handing over to the plugin
+        processor.setRateAndBufferSizeDetails (sampleRate, maxBlockSize);
+        processor.prepareToPlay (sampleRate, maxBlockSize);
+    }
+
+    template <typename SampleType>
+    PassResult runPass (std::vector<std::unique_ptr<AnimeAnalyzerAudioProcessor>>& instances,
+                        const Options& options, double sampleRate, juce::Random& random)
+    {
+        constexpr int numChannels = 2;
+        constexpr int signalLength = 1 << 17;
+
+        // Uncorrelated noise with a tone on top, read from a different place each cycle
+        juce::AudioBuffer<SampleType> signal (numChannels, signalLength + options.maxBlockSize);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < signal.getNumSamples(); ++i)
+                signal.setSample (ch, i, (SampleType) (0.5 * std::sin (0.05 * (i + ch * 7)) + 0.25 * (random.nextDouble() * 2.0 - 1.0)));
+
+        juce::AudioBuffer<SampleType> work (numChannels, options.maxBlockSize);
+        juce::MidiBuffer midi;
+
+        for (auto& instance : instances)
+            prepare (*instance, sampleRate, options.maxBlockSize);
+
+        PassResult result;
+        result.callbackMicros.reserve ((size_t) (options.seconds * sampleRate / options.blockSize * 1.5) * instances.size());
+
+        const auto allocationsBefore = callbackAllocations.load();
+        const auto locksBefore = callbackLocks.load();
+
+        const auto totalSamples = (juce::int64) (options.seconds * sampleRate);
+        const auto startMs = juce::Time::getMillisecondCounterHiRes();
+        juce::int64 position = 0;
+
+        while (position < totalSamples)
+        {
+            const auto numSamples = pickBlockSize (random, options);
+            const auto readPosition = (int) (position % signalLength);
+            const auto blockSeconds = numSamples / sampleRate;
+
+            if (options.paced)
+            {
+                // The callback is due once the previous block has played, give or take the jitter
+                const auto dueMs = startMs + (double) position * 1000.0 / sampleRate + random.nextDouble() * options.jitterMs;
+                const auto waitMs = (int) (dueMs - juce::Time::getMillisecondCounterHiRes());
+
+                if (waitMs > 0)
+                    juce::Thread::sleep (waitMs);
+            }
+
+            // Now and then the host prepares one instance again without stopping the rest
+            if (options.reprepareOneIn > 0 && random.nextInt (options.reprepareOneIn) == 0)
+            {
+                auto& instance = *instances[(size_t) random.nextInt ((int) instances.size())];
+
+                const auto prepareStart = juce::Time::getHighResolutionTicks();
+                prepare (instance, sampleRate, options.maxBlockSize);
+                result.maxPrepareMillis = juce::jmax (result.maxPrepareMillis, ticksToMicros (juce::Time::getHighResolutionTicks() - prepareStart) * 0.001);
+                ++result.numReprepares;
+            }
+
+            juce::int64 cycleTicks = 0;
+
+            for (auto& instance : instances)
+            {
+                for (int ch = 0; ch < numChannels; ++ch)
+                    work.copyFrom (ch, 0, signal, ch, readPosition, numSamples);
+
+                juce::AudioBuffer<SampleType> block (work.getArrayOfWritePointers(), numChannels, numSamples);
+
+                const auto callbackStart = juce::Time::getHighResolutionTicks();
+                insideCallback = true;
+                instance->processBlock (block, midi);
+                insideCallback = false;
+                const auto elapsed = juce::Time::getHighResolutionTicks() - callbackStart;
+
+                cycleTicks += elapsed;
+                result.callbackMicros.push_back (ticksToMicros (elapsed));
+            }
+
+            if (numSamples >= minLoadBlockSize)
+            {
+                const auto load = juce::Time::highResolutionTicksToSeconds (cycleTicks) / blockSeconds;
+
+                if (load > result.maxCycleLoad)
+                {
+                    result.maxCycleLoad = load;
+                    result.slowestBlockSize = numSamples;
+                }
+            }
+
+            position += numSamples;
+            ++result.numCycles;
+        }
+
+        result.allocations = callbackAllocations.load() - allocationsBefore;
+        result.locks = callbackLocks.load() - locksBefore;
+
+        for (auto& instance : instances)
+            instance->releaseResources();
+
+        std::sort (result.callbackMicros.begin(), result.callbackMicros.end());
+        return result;
+    }
+
+    //==============================================================================
+    bool checkBudgets (const PassResult& r, const Options& options)
+    {
+        juce::StringArray failures;
+
+        if (r.getPercentile (0.99) > options.p99BudgetMicros)   failures.add ("p99 over " + juce::String (options.p99BudgetMicros) + " us");
+        if (r.getPercentile (1.0) > options.maxBudgetMicros)    failures.add ("max over " + juce::String (options.maxBudgetMicros) + " us");
+        if (r.maxCycleLoad > options.maxLoadBudget)             failures.add ("cycle load over " + juce::String (options.maxLoadBudget));
+        if (r.allocations > options.allocationBudget)           failures.add (juce::String (r.allocations) + " allocations");
+        if (tracksLocks && r.locks > options.lockBudget)        failures.add (juce::String (r.locks) + " locks");
+
+        if (failures.isEmpty())
+            return true;
+
+        std::cout << "    FAILED: " << failures.joinIntoString (", ") << std::endl;
+        return false;
+    }
+
+    void printResult (const PassResult& r, double sampleRate)
+    {
+        std::cout << juce::String (sampleRate, 0).paddedLeft (' ', 7)
+                  << juce::String ((juce::int64) r.callbackMicros.size()).paddedLeft (' ', 10)
+                  << juce::String (r.getPercentile (0.5), 2).paddedLeft (' ', 9)
+                  << juce::String (r.getPercentile (0.9), 2).paddedLeft (' ', 9)
+                  << juce::String (r.getPercentile (0.99), 2).paddedLeft (' ', 9)
+                  << juce::String (r.getPercentile (0.999), 2).paddedLeft (' ', 9)
+                  << juce::String (r.getPercentile (1.0), 2).paddedLeft (' ', 10)
+                  << juce::String (r.maxCycleLoad, 3).paddedLeft (' ', 8)
+                  << juce::String (r.slowestBlockSize).paddedLeft (' ', 7)
+                  << juce::String (r.allocations).paddedLeft (' ', 7)
+                  << (tracksLocks ? juce::String (r.locks) : juce::String ("n/a")).paddedLeft (' ', 7)
+                  << juce::String (r.numReprepares).paddedLeft (' ', 6)
+                  << juce::String (r.maxPrepareMillis, 2).paddedLeft (' ', 9) << std::endl;
+    }
+
+    void printUsage()
+    {
+        std::cout << "usage: anime-analyzer-host-stress [--instances <n>] [--seconds <s>] [--rates <list>]\n"
+                     "                                  [--block <n>] [--max-block <n>] [--double] [--reprepare <n>]\n"
+                     "                                  [--jitter-ms <ms>] [--unpaced] [--seed <n>]\n"
+                     "                                  [--p99-us <us>] [--max-us <us>] [--max-load <x>]\n"
+                     "                                  [--allocations <n>] [--locks <n>]" << std::endl;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    Options options;
+
+    if (args.containsOption ("--instances"))
+        options.numInstances = juce::jlimit (1, 1024, args.getValueForOption ("--instances").getIntValue());
+
+    if (args.containsOption ("--seconds"))
+        options.seconds = juce::jlimit (0.1, 3600.0, args.getValueForOption ("--seconds").getDoubleValue());
+
+    if (args.containsOption ("--rates"))
+    {
+        options.sampleRates.clear();
+
+        for (auto& token : juce::StringArray::fromTokens (args.getValueForOption ("--rates"), ",", {}))
+            if (token.trim().getIntValue() > 0)
+                options.sampleRates.add (token.trim().getIntValue());
+    }
+
+    if (args.containsOption ("--max-block"))
+        options.maxBlockSize = juce::jlimit (1, 1 << 16, args.getValueForOption ("--max-block").getIntValue());
+
+    options.blockSize = juce::jmin (options.blockSize, options.maxBlockSize);
+
+    if (args.containsOption ("--block"))
+        options.blockSize = juce::jlimit (1, options.maxBlockSize, args.getValueForOption ("--block").getIntValue());
+
+    options.doublePrecision = args.containsOption ("--double");
+    options.paced = ! args.containsOption ("--unpaced");
+
+    if (args.containsOption ("--reprepare"))
+        options.reprepareOneIn = juce::jmax (0, args.getValueForOption ("--reprepare").getIntValue());
+
+    if (args.containsOption ("--jitter-ms"))
+        options.jitterMs = juce::jmax (0.0, args.getValueForOption ("--jitter-ms").getDoubleValue());
+
+    if (args.containsOption ("--seed"))
+        options.seed = args.getValueForOption ("--seed").getLargeIntValue();
+
+    if (args.containsOption ("--p99-us"))
+        options.p99BudgetMicros = args.getValueForOption ("--p99-us").getDoubleValue();
+
+    if (args.containsOption ("--max-us"))
+        options.maxBudgetMicros = args.getValueForOption ("--max-us").getDoubleValue();
+
+    if (args.containsOption ("--max-load"))
+        options.maxLoadBudget = args.getValueForOption ("--max-load").getDoubleValue();
+
+    if (args.containsOption ("--allocations"))
+        options.allocationBudget = args.getValueForOption ("--allocations").getLargeIntValue();
+
+    if (args.containsOption ("--locks"))
+        options.lockBudget = args.getValueForOption ("--locks").getLargeIntValue();
+
+    if (options.sampleRates.isEmpty())
+    {
+        std::cerr << "no sample rates" << std::endl;
+        return 1;
+    }
+
+    // The parameters' timers need a message manager, though nothing here runs its loop
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    std::vector<std::unique_ptr<AnimeAnalyzerAudioProcessor>> instances;
+
+    for (int i = 0; i < options.numInstances; ++i)
+    {
+        instances.push_back (std::make_unique<AnimeAnalyzerAudioProcessor>());
+        instances.back()->setProcessingPrecision (options.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                                          : juce::AudioProcessor::singlePrecision);
+    }
+
+    std::cout << options.numInstances << " instances, " << (options.doublePrecision ? "64" : "32") << "-bit, block "
+              << options.blockSize << " (max " << options.maxBlockSize << "), "
+              << (options.paced ? "paced" : "unpaced") << (tracksLocks ? "" : ", locks not tracked on this platform") << std::endl
+              << "   rate     calls   p50 us   p90 us   p99 us  p99.9 us    max us    load  block  alloc  locks  prep  prep ms" << std::endl;
+
+    juce::Random random (options.seed);
+    bool passed = true;
+
+    for (auto sampleRate : options.sampleRates)
+    {
+        const auto result = options.doublePrecision ? runPass<double> (instances, options, (double) sampleRate, random)
+                                                    : runPass<float>  (instances, options, (double) sampleRate, random);
+
+        printResult (result, (double) sampleRate);
+        passed = checkBudgets (result, options) && passed;
+    }
+
+    instances.clear();
+
+    std::cout << (passed ? "all budgets met" : "budgets exceeded") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+// Follows an analyser's shared memory stream from outside the plugin and prints
+// each frame as it arrives: the meters, and optionally the mid spectrum. Handy for
+// checking the stream works before pointing a visualiser at it.
+//
+//   anime-analyzer-stream --list
+//   anime-analyzer-stream [<name>] [--bands] [--frames <n>]
+//
+// Without a name it follows the only stream published on this machine.
+
+#include "../../Source/AnalysisStreamReader.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    double toDecibels (float level)
+    {
+        return level > 0.0f ? 20.0 * std::log10 ((double) level) : -100.0;
+    }
+
+    void printFrame (const AnalysisStream::Frame& frame, bool showBands)
+    {
+        std::printf ("#%-8llu %12lld smp  ", (unsigned long long) frame.frameIndex, (long long) frame.samplePosition);
+
+        for (std::uint32_t ch = 0; ch < frame.numChannels && ch < (std::uint32_t) AnalysisStream::maxChannels; ++ch)
+            std::printf ("%6.1f ", toDecibels (frame.rmsLevels[ch]));
+
+        std::printf (" corr %+5.2f  M %6.1f  S %6.1f  I %6.1f LUFS\n",
+                     frame.numCorrelationPairs > 0 ? frame.correlations[0] : 0.0f,
+                     frame.momentaryLoudness, frame.shortTermLoudness, frame.integratedLoudness);
+
+        if (showBands)
+        {
+            std::printf ("          ");
+
+            for (std::uint32_t band = 0; band < frame.numSpectrumBands && band < (std::uint32_t) AnalysisStream::maxSpectrumBands; ++band)
+                std::printf ("%3d", (int) std::lround (frame.spectrumBandLevels[0][band] * 99.0f));
+
+            std::printf ("\n");
+        }
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    std::string name;
+    bool showBands = false;
+    long maxFrames = -1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp (argv[i], "--list") == 0)
+        {
+            for (const auto& stream : AnalysisStreamReader::findStreams())
+                std::cout << stream << std::endl;
+
+            return 0;
+        }
+
+        if (std::strcmp (argv[i], "--bands") == 0)
+            showBands = true;
+        else if (std::strcmp (argv[i], "--frames") == 0 && i + 1 < argc)
+            maxFrames = std::atol (argv[++i]);
+        else
+            name = argv[i];
+    }
+
+    if (name.empty())
+    {
+        const auto streams = AnalysisStreamReader::findStreams();
+
+        if (streams.size() != 1)
+        {
+            std::cerr << (streams.empty() ? "No streams found" : "More than one stream; pick one from --list") << std::endl;
+            return 1;
+        }
+
+        name = streams.front();
+    }
+
+    AnalysisStreamReader reader;
+
+    if (! reader.open (name))
+    {
+        std::cerr << reader.getLastError() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Following " << name << std::endl;
+
+    AnalysisStream::Frame frame;
+    long numPrinted = 0;
+
+    while (maxFrames < 0 || numPrinted < maxFrames)
+    {
+        if (reader.readNext (frame))
+        {
+            printFrame (frame, showBands);
+            ++numPrinted;
+            continue;
+        }
+
+        if (reader.isWriterClosed())
+        {
+            std::cout << "The writer closed the stream" << std::endl;
+            break;
+        }
+
+        std::this_thread::sleep_for (std::chrono::milliseconds (10));
+    }
+
+    if (reader.getNumSkippedFrames() > 0)
+        std::cout << reader.getNumSkippedFrames() << " frames skipped while falling behind" << std::endl;
+
+    return 0;
+}